@@ -0,0 +1,186 @@
+/**
+ * @file 		  bench.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: bench.cpp $
+ *
+ * @brief  Benchmark firmware: cycles for ISRs and API calls, measured in simavr.
+ *
+ * Each measurement writes its name to GPIOR0, then a start marker to GPIOR1 
+ * and a stop marker to GPIOR2. The simavr harness (simbench.c) notes the 
+ * cycle counter at each marker write and prints the difference. Names 
+ * starting with '.' are calibrations: they are not printed, but their result
+ * is subtracted from measurements. A measurement named "xxx@cal" uses 
+ * calibration ".cal", all others use ".empty" (just the markers).
+ *
+ * ISR cost is measured by waiting, with interrupts disabled, until the 
+ * interrupt flag is set, then executing `sei; nop; cli` between the markers,
+ * so the ISR runs exactly once in between. The `.irq` calibration does the 
+ * same without a pending interrupt.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+
+#include "AvrTimers.h"
+
+
+AvrTimer0 timer0;
+AvrTimer1 timer1;
+AvrTimer2 timer2;
+
+volatile uint32_t sink;
+
+//---------------------------------------------------------------------------
+
+/// @brief send the name of the next measurement to the harness
+static void bench_name(const char* s)
+{
+	char c;
+	while ((c = pgm_read_byte(s++))) 
+		GPIOR0 = c;
+	GPIOR0 = 0;
+}
+
+#define BARRIER()		__asm__ __volatile__ ("" ::: "memory")
+#define BENCH_START(s)	do { bench_name(PSTR(s)); BARRIER(); GPIOR1 = 1; BARRIER(); } while (0)
+#define BENCH_STOP()	do { BARRIER(); GPIOR2 = 1; BARRIER(); } while (0)
+
+
+/// @brief run the ISR for the flag `mask` in `tifr` exactly once, between markers
+#define BENCH_ISR(s, tifr, mask) \
+	do { \
+		cli(); \
+		tifr = mask; \
+		while (!(tifr & mask)) {} \
+		BENCH_START(s "@irq"); \
+		__asm__ __volatile__ ("sei" "\n\t" "nop" "\n\t" "cli" ::: "memory"); \
+		BENCH_STOP(); \
+	} while (0)
+
+
+static void nop_task(void*) {}
+
+
+/// @brief run the ISR of `timer` with 0..4 tasks, each called on every tick
+#define BENCH_ISR_TASKS(timer, s, tifr, mask) \
+	do { \
+		for (uint8_t n=0; n<=AvrTimerBase::MAX_TIMER_TASKS; n++) { \
+			if (n) timer.add_task( 1, nop_task ); \
+			switch (n) { \
+				case 0:	BENCH_ISR(s ".isr.tasks0", tifr, mask); break; \
+				case 1:	BENCH_ISR(s ".isr.tasks1", tifr, mask); break; \
+				case 2:	BENCH_ISR(s ".isr.tasks2", tifr, mask); break; \
+				case 3:	BENCH_ISR(s ".isr.tasks3", tifr, mask); break; \
+				default: BENCH_ISR(s ".isr.tasks4", tifr, mask); break; \
+			} \
+		} \
+	} while (0)
+
+
+//---------------------------------------------------------------------------
+
+static void bench_timer0(void)
+{
+	BENCH_START("T0.begin");
+	timer0.begin( 1000uL, AvrTimerBase::ActiveHigh );
+	BENCH_STOP();
+	timer0.start();
+
+	BENCH_ISR_TASKS( timer0, "T0", TIFR0, _BV(OCF0A) );
+
+	BENCH_START("T0.get_millis");
+	sink = timer0.get_millis();
+	BENCH_STOP();
+
+	BENCH_START("T0.get_micros");
+	sink = timer0.get_micros();
+	BENCH_STOP();
+
+	BENCH_START("T0.setPWM_B");
+	timer0.setPWM_B( 100 );
+	BENCH_STOP();
+
+	timer0.stop();
+}
+
+
+static void bench_timer1(void)
+{
+	BENCH_START("T1.begin");
+	timer1.begin( 500, AvrTimerBase::ActiveHigh, AvrTimerBase::ActiveHigh );
+	BENCH_STOP();
+	timer1.start();
+
+	BENCH_ISR_TASKS( timer1, "T1", TIFR1, _BV(TOV1) );
+
+	BENCH_START("T1.get_millis");
+	sink = timer1.get_millis();
+	BENCH_STOP();
+
+	BENCH_START("T1.setPWM_A");
+	timer1.setPWM_A( 1024, 2048 );
+	BENCH_STOP();
+
+	BENCH_START("T1.setPWM_B");
+	timer1.setPWM_B( 512, 2048 );
+	BENCH_STOP();
+
+	timer1.stop();
+}
+
+
+static void bench_timer2(void)
+{
+	BENCH_START("T2.begin");
+	timer2.begin( 100 );
+	BENCH_STOP();
+	timer2.start();
+
+	BENCH_ISR_TASKS( timer2, "T2", TIFR2, _BV(OCF2A) );
+
+	BENCH_START("T2.get_millis");
+	sink = timer2.get_millis();
+	BENCH_STOP();
+
+	timer2.stop();
+}
+
+//---------------------------------------------------------------------------
+
+int main(void)
+{
+	// calibrate marker overhead
+	BENCH_START(".empty");
+	BENCH_STOP();
+
+	// calibrate the sei/nop/cli sequence without a pending interrupt
+	cli();
+	BENCH_START(".irq");
+	__asm__ __volatile__ ("sei" "\n\t" "nop" "\n\t" "cli" ::: "memory");
+	BENCH_STOP();
+
+	bench_timer0();
+	bench_timer1();
+	bench_timer2();
+
+	// done: simavr exits when the CPU sleeps with interrupts disabled
+	cli();
+	sleep_enable();
+	sleep_cpu();
+	for (;;) {}
+}
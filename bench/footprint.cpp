@@ -0,0 +1,107 @@
+/**
+ * @file 		  footprint.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: footprint.cpp $
+ *
+ * @brief  Minimal firmware to measure the flash and RAM footprint of one configuration.
+ *
+ * The Makefile builds this once per entry in the configuration matrix, 
+ * selecting features with these macros:
+ *  - `FP_TIMER`   0, 1 or 2: which timer to use, -1 for none (runtime overhead only)
+ *  - `FP_MILLIS`  1: the timer also maintains `millis()`
+ *  - `FP_TASKS`   number of tasks, 0..4
+ *  - `FP_PWM`     1: use PWM output(s)
+ *  - `FP_ASYNC`   1: Timer2 in async mode
+ * and the library's own macros like `DEBUG_AVRTIMERS`.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "AvrTimers.h"
+
+#ifndef FP_TIMER
+ #define FP_TIMER 0
+#endif
+#ifndef FP_MILLIS
+ #define FP_MILLIS 0
+#endif
+#ifndef FP_TASKS
+ #define FP_TASKS 0
+#endif
+#ifndef FP_PWM
+ #define FP_PWM 0
+#endif
+#ifndef FP_ASYNC
+ #define FP_ASYNC 0
+#endif
+
+#if FP_TIMER==0
+ AvrTimer0 timer;
+#elif FP_TIMER==1
+ AvrTimer1 timer;
+#elif FP_TIMER==2
+ AvrTimer2 timer;
+#endif
+
+volatile uint32_t sink;
+
+#if FP_TASKS
+static void task(void*) { sink++; }
+#endif
+
+
+int main(void)
+{
+#if FP_TIMER >= 0
+
+ #if FP_MILLIS
+	timer.handle_millis();
+ #endif
+
+ #if FP_TIMER==0
+	timer.begin( 1000uL, FP_PWM ? AvrTimerBase::ActiveHigh : AvrTimerBase::Disabled );
+  #if FP_PWM
+	timer.setPWM_B( 100 );
+  #endif
+ #elif FP_TIMER==1
+	timer.begin( 500, FP_PWM ? AvrTimerBase::ActiveHigh : AvrTimerBase::Disabled, 
+					  FP_PWM ? AvrTimerBase::ActiveHigh : AvrTimerBase::Disabled );
+  #if FP_PWM
+	timer.setPWM_A( 1024, 2048 );
+	timer.setPWM_B( 512, 2048 );
+  #endif
+ #else
+	timer.begin( 100, 0, NULL, FP_ASYNC ? 32768uL : F_CPU, FP_ASYNC );
+ #endif
+
+#if FP_TASKS
+	for (uint8_t i=0; i<FP_TASKS; i++)
+		timer.add_task( i+1, task );
+#endif
+
+	timer.start();
+	sei();
+#endif // FP_TIMER
+
+	for (;;) {
+#if FP_MILLIS
+		sink = millis();
+#elif FP_TIMER >= 0
+		sink = timer.get_millis();
+#endif
+	}
+}
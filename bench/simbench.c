@@ -0,0 +1,165 @@
+/**
+ * @file 		  simbench.c
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: simbench.c $
+ *
+ * @brief  Run a benchmark firmware in simavr, print cycles between markers.
+ *
+ * usage: simbench firmware.elf [mcu [f_cpu]]
+ *
+ * The firmware writes a measurement name to GPIOR0, one character at a time,
+ * terminated by 0, then any value to GPIOR1 (start) and GPIOR2 (stop). 
+ * For each measurement, one line is printed to stdout:
+ *     mcu <TAB> f_cpu <TAB> name <TAB> cycles
+ * where cycles is the raw count minus the calibration, see bench.cpp.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+
+// data space addresses of the general purpose I/O registers (ATmega48..328)
+#define ADDR_GPIOR0	0x3E
+#define ADDR_GPIOR1	0x4A
+#define ADDR_GPIOR2	0x4B
+
+#define MAX_NAME	40
+#define MAX_CAL		8
+
+static const char* s_mcu;
+static unsigned long s_fcpu;
+
+static char s_name[MAX_NAME+1];
+static int s_len;
+static avr_cycle_count_t s_start;
+static int s_count;
+
+/// calibrations, by name
+static struct { char name[MAX_NAME+1]; avr_cycle_count_t cycles; } s_cal[MAX_CAL];
+static int s_ncal;
+
+//---------------------------------------------------------------------------
+
+static avr_cycle_count_t get_cal(const char* name)
+{
+	for (int i=0; i<s_ncal; i++)
+		if (strcmp(s_cal[i].name, name)==0) return s_cal[i].cycles;
+	return 0;
+}
+
+
+static void set_cal(const char* name, avr_cycle_count_t cycles)
+{
+	int i;
+	for (i=0; i<s_ncal; i++)
+		if (strcmp(s_cal[i].name, name)==0) break;
+	if (i==MAX_CAL) return;
+	if (i==s_ncal) s_ncal++;
+	strcpy( s_cal[i].name, name );
+	s_cal[i].cycles = cycles;
+}
+
+//---------------------------------------------------------------------------
+
+/// GPIOR0 write: next character of the measurement name
+static void on_name(struct avr_t* avr, avr_io_addr_t addr, uint8_t v, void* param)
+{
+	avr->data[addr] = v;
+	if (v==0) {
+		s_name[s_len] = 0;
+		s_len = 0;
+	} else if (s_len < MAX_NAME) {
+		s_name[s_len++] = (char)v;
+	}
+}
+
+
+/// GPIOR1 write: start of measurement
+static void on_start(struct avr_t* avr, avr_io_addr_t addr, uint8_t v, void* param)
+{
+	avr->data[addr] = v;
+	s_start = avr->cycle;
+}
+
+
+/// GPIOR2 write: end of measurement
+static void on_stop(struct avr_t* avr, avr_io_addr_t addr, uint8_t v, void* param)
+{
+	avr->data[addr] = v;
+	avr_cycle_count_t raw = avr->cycle - s_start;
+
+	if (s_name[0]=='.') {
+		set_cal( s_name, raw );
+		return;
+	}
+
+	char cal[MAX_NAME+2] = ".empty";
+	char* at = strchr(s_name, '@');
+	if (at) {
+		*at = 0;
+		snprintf( cal, sizeof(cal), ".%s", at+1 );
+	}
+	long cycles = (long)(raw - get_cal(cal));
+	printf("%s\t%lu\t%s\t%ld\n", s_mcu, s_fcpu, s_name, cycles);
+	s_count++;
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s firmware.elf [mcu [f_cpu]]\n", argv[0]);
+		return 2;
+	}
+	s_mcu = (argc > 2) ? argv[2] : "atmega328p";
+	s_fcpu = (argc > 3) ? strtoul(argv[3], NULL, 0) : 8000000uL;
+
+	elf_firmware_t fw;
+	memset( &fw, 0, sizeof(fw) );
+	if (elf_read_firmware(argv[1], &fw) != 0) {
+		fprintf(stderr, "can't read %s\n", argv[1]);
+		return 2;
+	}
+
+	avr_t* avr = avr_make_mcu_by_name(s_mcu);
+	if (!avr) {
+		fprintf(stderr, "unknown MCU %s\n", s_mcu);
+		return 2;
+	}
+	avr_init(avr);
+	fw.frequency = s_fcpu;
+	avr_load_firmware(avr, &fw);
+	avr->frequency = s_fcpu;
+
+	avr_register_io_write(avr, ADDR_GPIOR0, on_name, NULL);
+	avr_register_io_write(avr, ADDR_GPIOR1, on_start, NULL);
+	avr_register_io_write(avr, ADDR_GPIOR2, on_stop, NULL);
+
+	int state = cpu_Running;
+	while (state != cpu_Done && state != cpu_Crashed)
+		state = avr_run(avr);
+
+	if (state == cpu_Crashed || s_count == 0) {
+		fprintf(stderr, "%s: firmware crashed or reported nothing\n", argv[1]);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file 		  main.cpp
+ * Project		: test AvrTimer
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Measure the supply current saved by switching off idle timers.
+ *
+ * Timer2 runs in async mode from a 32.768 kHz watch crystal and counts seconds. 
+ * Every 10 seconds, the application alternates between two phases:
+ * - phase 1: Timer1 runs at 1000 Hz with a task that blinks an LED
+ * - phase 2: the Timer1 task is disabled and Timer1 is stopped. Since nothing 
+ *   depends on Timer1 any more, stop() also switches it off via PRR.
+ * 
+ * The CPU sleeps in idle mode between interrupts. Connect a multimeter in 
+ * the supply line, and compare the current in both phases (the LED is off in
+ * phase 2, so disconnect it or subtract its current for a fair comparison).
+ * The difference depends on board, clock frequency and supply voltage, so 
+ * note these with the readings; the "supply current of I/O modules" table in
+ * the datasheet gives the expected order of magnitude.
+ */
+
+#define __STDC_LIMIT_MACROS
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include "AvrTimers.h"
+
+#define LED_DDR		DDRB
+#define LED_PORT	PORTB
+#define LED_BIT		PB5
+
+AvrTimer1 timer1;
+AvrTimer2 timer2;
+
+volatile uint8_t seconds = 0;
+
+
+// Timer2 task, once per second
+void count_seconds( void* )
+{
+    seconds++;
+}
+
+
+// Timer1 task, every 100 ms
+void blink( void* )
+{
+    LED_PORT ^= _BV(LED_BIT);
+}
+
+
+int main()
+{
+    LED_DDR |= _BV(LED_BIT);
+
+    // Timer2: 32 Hz interrupt rate from watch crystal, task once per second
+    timer2.begin( 32, 1, NULL, 32768uL, true );
+    timer2.add_task( 1, count_seconds );
+    timer2.start();
+
+    // Timer1: 1000 Hz interrupt rate, task every 100 ms
+    timer1.begin( 1000 );
+    uint8_t task = timer1.add_task( 100, blink );
+    timer1.start();
+
+    sei();
+    set_sleep_mode( SLEEP_MODE_IDLE );
+
+    bool active = true;
+    for (;;) {
+        if (seconds >= 10) {
+            seconds = 0;
+            active = !active;
+            if (active) {
+                // phase 1: Timer1 switched on again, with its previous configuration
+                timer1.enable_task( task );
+                timer1.start();
+            } else {
+                // phase 2: no task depends on Timer1, so stop() also sets PRR.PRTIM1
+                timer1.disable_task( task );
+                timer1.stop();
+                LED_PORT &= ~_BV(LED_BIT);
+            }
+        }
+        sleep_mode();
+    }
+}
@@ -0,0 +1,704 @@
+/**
+ * @file 		  AvrSim.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrSim.cpp $
+ *
+ * @brief  Host simulation of ATmega328P register file and Timer/Counters 0, 1, 2.
+ */
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <avr/io.h>
+#include "AvrSim.h"
+
+#ifndef F_CPU
+ #define F_CPU 8000000
+#endif
+
+/// frequency of the watch crystal for async Timer2 [Hz]
+#define F_TOSC 32768uL
+
+//---------------------------------------------------------------------------
+// interrupt vectors: weak references, NULL if the firmware doesn't define an ISR
+
+typedef void (*vector_t)(void);
+
+#define VEC(n) extern "C" void __vector_##n(void) __attribute__((weak));
+VEC(1) VEC(2) VEC(3) VEC(4) VEC(5) VEC(6) VEC(7) VEC(8) VEC(9) VEC(10)
+VEC(11) VEC(12) VEC(13) VEC(14) VEC(15) VEC(16) VEC(17) VEC(18) VEC(19) VEC(20)
+VEC(21) VEC(22) VEC(23) VEC(24) VEC(25)
+#undef VEC
+
+static vector_t const s_vectors[avrsim::NUM_VECTORS] = {
+	NULL, __vector_1, __vector_2, __vector_3, __vector_4, __vector_5,
+	__vector_6, __vector_7, __vector_8, __vector_9, __vector_10,
+	__vector_11, __vector_12, __vector_13, __vector_14, __vector_15,
+	__vector_16, __vector_17, __vector_18, __vector_19, __vector_20,
+	__vector_21, __vector_22, __vector_23, __vector_24, __vector_25
+};
+
+namespace avrsim {
+
+//---------------------------------------------------------------------------
+// register addresses
+
+enum {
+	A_TIFR0=0x35, A_TIFR1=0x36, A_TIFR2=0x37, A_EIFR=0x3C, A_EIMSK=0x3D,
+	A_GTCCR=0x43, A_TCCR0A=0x44, A_TCCR0B=0x45, A_TCNT0=0x46, A_OCR0A=0x47, A_OCR0B=0x48,
+	A_MCUSR=0x54, A_SPL=0x5D, A_SPH=0x5E, A_SREG=0x5F, A_CLKPR=0x61, A_PRR=0x64,
+	A_TIMSK0=0x6E, A_TIMSK1=0x6F, A_TIMSK2=0x70,
+	A_TCCR1A=0x80, A_TCCR1B=0x81, A_TCNT1=0x84, A_ICR1=0x86, A_OCR1A=0x88, A_OCR1B=0x8A,
+	A_TCCR2A=0xB0, A_TCCR2B=0xB1, A_TCNT2=0xB2, A_OCR2A=0xB3, A_OCR2B=0xB4, A_ASSR=0xB6,
+};
+
+/// state of one Timer/Counter
+typedef struct _timer_t {
+	uint8_t  id;
+	bool     wide;				///< 16-bit timer
+	uint8_t  a_tccra, a_tccrb, a_tcnt, a_ocra, a_ocrb, a_timsk, a_tifr;
+	uint8_t  prbit;				///< bit in PRR
+	uint8_t  vec_compa, vec_compb, vec_ovf, vec_capt;
+	uint16_t cnt;
+	uint16_t ocra, ocrb;		///< compare values in use (OCRnx may be double buffered)
+	uint16_t psc;				///< prescaler counter, T2 only
+} timer_t;
+
+static uint8_t  s_io[0x100];		///< register file
+static timer_t  s_t[3];
+static uint64_t s_cycles;			///< oscillator cycles since reset
+static uint32_t s_clkio;			///< clk_io cycles since reset, mod 2^32
+static uint16_t s_psc;				///< shared prescaler of T0 and T1
+static uint32_t s_tosc_acc;			///< fractional TOSC1 clocks
+static uint8_t  s_async_busy[5];	///< TOSC1 edges until ASSR busy flag clears
+static uint8_t  s_clkpce;			///< clk_io cycles left to write CLKPR after CLKPCE
+static uint32_t s_soft_pending;		///< pending interrupts raised by raise()
+static uint16_t s_isr_cycles;
+static uint8_t  s_depth;			///< ISR nesting depth
+static uint32_t s_count[NUM_VECTORS];
+static bool     s_woken;
+
+static const uint16_t T01_div[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+static const uint16_t T2_div[8]  = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+static void tick_clkio(void);
+static void tick_tosc(void);
+static void check_interrupts(void);
+static uint64_t cycles_for_tosc(uint64_t m);
+
+//---------------------------------------------------------------------------
+
+/// @brief waveform generation mode of a timer
+static uint8_t wgm(const timer_t& t)
+{
+	uint8_t a = s_io[t.a_tccra], b = s_io[t.a_tccrb];
+	if (t.wide)
+		return (a & 3) | (((b >> WGM12) & 3) << 2);
+	else
+		return (a & 3) | (((b >> WGM02) & 1) << 2);
+}
+
+
+/// @brief value of TOP for the current mode
+static uint16_t top(const timer_t& t)
+{
+	uint8_t m = wgm(t);
+	if (t.wide) {
+		switch (m) {
+			case 4: case 9: case 11: case 15:
+				return t.ocra;
+			case 8: case 10: case 12: case 14:
+				return s_io[A_ICR1] | (s_io[A_ICR1+1] << 8);
+			case 1: case 5:	return 0x00FF;
+			case 2: case 6:	return 0x01FF;
+			case 3: case 7:	return 0x03FF;
+			default:		return 0xFFFF;
+		}
+	} else {
+		return (m == 2 || m == 5 || m == 7) ? t.ocra : 0xFF;
+	}
+}
+
+
+/// @brief true if the current mode is a fast PWM mode (compare registers are double buffered)
+static bool is_pwm(const timer_t& t)
+{
+	uint8_t m = wgm(t);
+	if (t.wide)
+		return m != 0 && m != 4 && m != 12;
+	else
+		return m != 0 && m != 2;
+}
+
+
+/// @brief true if TOV is set at TOP rather than at MAX
+static bool tov_at_top(const timer_t& t)
+{
+	return is_pwm(t);
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief Advance a timer by one count
+static void count(timer_t& t)
+{
+	uint16_t tp = top(t);
+	uint16_t max = t.wide ? 0xFFFF : 0xFF;
+	uint8_t& tifr = s_io[t.a_tifr];
+
+	if (t.cnt == tp) {
+		t.cnt = 0;
+		if (!tov_at_top(t) && tp == max) tifr |= _BV(TOV0);
+		if (is_pwm(t)) {
+			// double buffered compare registers are updated at BOTTOM
+			if (t.wide) {
+				t.ocra = s_io[A_OCR1A] | (s_io[A_OCR1A+1] << 8);
+				t.ocrb = s_io[A_OCR1B] | (s_io[A_OCR1B+1] << 8);
+			} else {
+				t.ocra = s_io[t.a_ocra];
+				t.ocrb = s_io[t.a_ocrb];
+			}
+		}
+	} else if (t.cnt == max) {
+		t.cnt = 0;			// TOP below current count, e.g. after lowering OCRnA
+		tifr |= _BV(TOV0);
+	} else {
+		t.cnt++;
+	}
+
+	if (t.cnt == t.ocra) tifr |= _BV(OCF0A);
+	if (t.cnt == t.ocrb) tifr |= _BV(OCF0B);
+	if (t.wide && wgm(t) == 12 && t.cnt == tp) tifr |= _BV(ICF1);
+	if (tov_at_top(t) && t.cnt == tp) tifr |= _BV(TOV0);
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief one cycle of the I/O clock: prescalers of T0, T1, and T2 if synchronous
+static void tick_clkio(void)
+{
+	s_clkio++;
+	if (s_clkpce) s_clkpce--;
+
+	s_psc = (s_psc + 1) & 0x3FF;
+	for (uint8_t i=0; i<2; i++) {
+		timer_t& t = s_t[i];
+		if (s_io[A_PRR] & _BV(t.prbit)) continue;
+		uint16_t div = T01_div[s_io[t.a_tccrb] & 7];
+		if (div && (s_psc & (div-1)) == 0) count(t);
+	}
+	if (!(s_io[A_ASSR] & _BV(AS2))) tick_tosc();
+}
+
+
+/// @brief one cycle of the Timer2 clock source: clk_io, or TOSC1 in async mode
+static void tick_tosc(void)
+{
+	timer_t& t = s_t[2];
+
+	if (s_io[A_ASSR] & _BV(AS2)) {
+		for (uint8_t i=0; i<5; i++) {
+			if (s_async_busy[i] && --s_async_busy[i] == 0)
+				s_io[A_ASSR] &= ~_BV(i);
+		}
+	}
+	if (s_io[A_PRR] & _BV(t.prbit)) return;
+	t.psc = (t.psc + 1) & 0x3FF;
+	uint16_t div = T2_div[s_io[t.a_tccrb] & 7];
+	if (div && (t.psc & (div-1)) == 0) count(t);
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief call an ISR, like the hardware: clear I, call, then reti sets I
+static void dispatch(uint8_t vec)
+{
+	s_count[vec]++;
+	s_woken = true;
+	s_io[A_SREG] &= ~_BV(SREG_I);
+	s_depth++;
+	if (s_isr_cycles) step(s_isr_cycles);
+	if (s_vectors[vec]) s_vectors[vec]();
+	s_depth--;
+	s_io[A_SREG] |= _BV(SREG_I);
+}
+
+
+/**
+ * @brief find the highest priority pending interrupt
+ * @return vector number, or 0 if none
+ */
+static uint8_t pending(void)
+{
+	if (s_soft_pending) {
+		for (uint8_t v=1; v<TIMER2_COMPA_vect_num; v++)
+			if (s_soft_pending & (1uL << v)) return v;
+	}
+	// vectors 7..16 are the timer interrupts, in order T2, T1, T0
+	static const uint8_t order[3] = { 2, 1, 0 };
+	for (uint8_t k=0; k<3; k++) {
+		timer_t& t = s_t[order[k]];
+		uint8_t f = s_io[t.a_tifr] & s_io[t.a_timsk];
+		if (!f) continue;
+		if (t.vec_capt && (f & _BV(ICF1))) return t.vec_capt;
+		if (f & _BV(OCF0A)) return t.vec_compa;
+		if (f & _BV(OCF0B)) return t.vec_compb;
+		if (f & _BV(TOV0)) return t.vec_ovf;
+	}
+	if (s_soft_pending) {
+		for (uint8_t v=SPI_STC_vect_num; v<NUM_VECTORS; v++)
+			if (s_soft_pending & (1uL << v)) return v;
+	}
+	return 0;
+}
+
+
+/// @brief dispatch all pending interrupts, if interrupts are enabled
+static void check_interrupts(void)
+{
+	while (s_io[A_SREG] & _BV(SREG_I)) {
+		uint8_t vec = pending();
+		if (!vec) break;
+		if (s_soft_pending & (1uL << vec)) {
+			s_soft_pending &= ~(1uL << vec);
+		} else {
+			// hardware clears the flag when the vector is executed
+			for (uint8_t i=0; i<3; i++) {
+				timer_t& t = s_t[i];
+				if (vec == t.vec_compa) s_io[t.a_tifr] &= ~_BV(OCF0A);
+				if (vec == t.vec_compb) s_io[t.a_tifr] &= ~_BV(OCF0B);
+				if (vec == t.vec_ovf)   s_io[t.a_tifr] &= ~_BV(TOV0);
+				if (vec == t.vec_capt)  s_io[t.a_tifr] &= ~_BV(ICF1);
+			}
+		}
+		dispatch(vec);
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Reset the simulated MCU: all registers to their reset values, time to 0
+ * @param mcusr  value of MCUSR after reset, default is power-on reset
+ */
+void reset(uint8_t mcusr)
+{
+	memset( s_io, 0, sizeof(s_io) );
+	memset( s_t, 0, sizeof(s_t) );
+	memset( s_async_busy, 0, sizeof(s_async_busy) );
+	memset( s_count, 0, sizeof(s_count) );
+	s_cycles = 0;
+	s_clkio = 0;
+	s_psc = 0;
+	s_tosc_acc = 0;
+	s_clkpce = 0;
+	s_soft_pending = 0;
+	s_depth = 0;
+
+	s_io[A_MCUSR] = mcusr;
+	s_io[A_SPL] = RAMEND & 0xFF;
+	s_io[A_SPH] = RAMEND >> 8;
+
+	static const timer_t init[3] = {
+		{ 0, false, A_TCCR0A, A_TCCR0B, A_TCNT0, A_OCR0A, A_OCR0B, A_TIMSK0, A_TIFR0, PRTIM0,
+		  TIMER0_COMPA_vect_num, TIMER0_COMPB_vect_num, TIMER0_OVF_vect_num, 0, 0,0,0,0 },
+		{ 1, true,  A_TCCR1A, A_TCCR1B, A_TCNT1, A_OCR1A, A_OCR1B, A_TIMSK1, A_TIFR1, PRTIM1,
+		  TIMER1_COMPA_vect_num, TIMER1_COMPB_vect_num, TIMER1_OVF_vect_num, TIMER1_CAPT_vect_num, 0,0,0,0 },
+		{ 2, false, A_TCCR2A, A_TCCR2B, A_TCNT2, A_OCR2A, A_OCR2B, A_TIMSK2, A_TIFR2, PRTIM2,
+		  TIMER2_COMPA_vect_num, TIMER2_COMPB_vect_num, TIMER2_OVF_vect_num, 0, 0,0,0,0 },
+	};
+	memcpy( s_t, init, sizeof(s_t) );
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief timer whose registers include `addr`, or NULL
+static timer_t* timer_at(uint8_t addr)
+{
+	for (uint8_t i=0; i<3; i++) {
+		timer_t& t = s_t[i];
+		if (addr == t.a_tcnt || addr == t.a_ocra || addr == t.a_ocrb
+		 || (t.wide && (addr == t.a_tcnt+1 || addr == t.a_ocra+1 || addr == t.a_ocrb+1)))
+			return &t;
+	}
+	return NULL;
+}
+
+
+/// @brief Read an I/O register, with side effects like the hardware
+uint8_t read8(uint8_t addr)
+{
+	switch (addr) {
+		case A_TCNT0:	return s_t[0].cnt;
+		case A_TCNT1:	return s_t[1].cnt & 0xFF;
+		case A_TCNT1+1:	return s_t[1].cnt >> 8;
+		case A_TCNT2:	return s_t[2].cnt;
+		case A_ASSR:
+			// firmware busy-waits on ASSR, so let time pass until the next TOSC1 edge
+			if (s_io[A_ASSR] & 0x1F) fast_forward( cycles_for_tosc(1) );
+			return s_io[A_ASSR];
+		default:		return s_io[addr];
+	}
+}
+
+
+/// @brief Write an I/O register, with side effects like the hardware
+void write8(uint8_t addr, uint8_t v)
+{
+	bool async = s_io[A_ASSR] & _BV(AS2);
+
+	switch (addr) {
+		case A_TIFR0: case A_TIFR1: case A_TIFR2: case A_EIFR:
+			s_io[addr] &= ~v;		// write one to clear
+			return;
+		case A_SREG:
+			s_io[addr] = v;
+			check_interrupts();
+			return;
+		case A_CLKPR:
+			if (v & _BV(CLKPCE)) {
+				s_clkpce = 4;
+			} else if (s_clkpce) {
+				s_io[addr] = v & 0x0F;
+				s_clkpce = 0;
+			}
+			return;
+		case A_ASSR:
+			s_io[addr] = (s_io[addr] & 0x1F) | (v & 0x60);
+			return;
+		case A_GTCCR:
+			if (v & _BV(PSRSYNC)) s_psc = 0;
+			if (v & _BV(PSRASY)) s_t[2].psc = 0;
+			s_io[addr] = v & _BV(TSM);
+			return;
+		case A_TCNT0:	s_t[0].cnt = v; break;
+		case A_TCNT1:	s_t[1].cnt = (s_t[1].cnt & 0xFF00) | v; break;
+		case A_TCNT1+1:	s_t[1].cnt = (s_t[1].cnt & 0x00FF) | (v << 8); break;
+		case A_TCNT2:	s_t[2].cnt = v; break;
+	}
+	s_io[addr] = v;
+
+	// compare registers take effect immediately, unless double buffered
+	timer_t* t = timer_at(addr);
+	if (t && addr != t->a_tcnt && !(t->wide && addr == t->a_tcnt+1) && !is_pwm(*t)) {
+		if (t->wide) {
+			t->ocra = s_io[A_OCR1A] | (s_io[A_OCR1A+1] << 8);
+			t->ocrb = s_io[A_OCR1B] | (s_io[A_OCR1B+1] << 8);
+		} else {
+			t->ocra = s_io[t->a_ocra];
+			t->ocrb = s_io[t->a_ocrb];
+		}
+	}
+
+	// async Timer2 registers are synchronized to TOSC1, ASSR shows busy
+	if (async) {
+		int8_t ub = -1;
+		switch (addr) {
+			case A_TCNT2:	ub = TCN2UB; break;
+			case A_OCR2A:	ub = OCR2AUB; break;
+			case A_OCR2B:	ub = OCR2BUB; break;
+			case A_TCCR2A:	ub = TCR2AUB; break;
+			case A_TCCR2B:	ub = TCR2BUB; break;
+		}
+		if (ub >= 0) {
+			s_io[A_ASSR] |= _BV(ub);
+			s_async_busy[ub] = 2;
+		}
+	}
+}
+
+
+/// @brief Read a 16-bit register, low byte first like the hardware
+uint16_t read16(uint8_t addr)
+{
+	uint8_t lo = read8(addr);
+	return lo | (read8(addr+1) << 8);
+}
+
+
+/// @brief Write a 16-bit register, high byte first like the hardware
+void write16(uint8_t addr, uint16_t v)
+{
+	uint8_t hi = v >> 8;
+	if (addr == A_TCNT1) {
+		s_t[1].cnt = v;
+		s_io[addr] = v & 0xFF;
+		s_io[addr+1] = hi;
+		return;
+	}
+	s_io[addr+1] = hi;
+	write8(addr, v & 0xFF);
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Advance simulated time by some oscillator cycles, cycle by cycle.
+ * The CPU and I/O clock is the oscillator divided by the CLKPR prescaler.
+ * Cycles that pass inside ISRs called from here, e.g. busy-waiting on ASSR, 
+ * count towards `n`.
+ */
+void step(uint64_t n)
+{
+	uint64_t end = s_cycles + n;
+	while (s_cycles < end) {
+		s_cycles++;
+		uint32_t clkmask = (1uL << (s_io[A_CLKPR] & 0x0F)) - 1;
+		if ((s_cycles & clkmask) == 0) tick_clkio();
+		if (s_io[A_ASSR] & _BV(AS2)) {
+			s_tosc_acc += F_TOSC;
+			if (s_tosc_acc >= F_CPU) {
+				s_tosc_acc -= F_CPU;
+				tick_tosc();
+			}
+		}
+		check_interrupts();
+	}
+}
+
+
+/// @brief convert [us] to oscillator cycles
+static uint64_t us_to_cycles(uint64_t us)
+{
+	return us * (F_CPU / 1000000uL) + (us * (F_CPU % 1000000uL)) / 1000000uL;
+}
+
+
+/// @brief Advance simulated time [us]
+void run_us(uint64_t us)
+{
+	step( us_to_cycles(us) );
+}
+
+//---------------------------------------------------------------------------
+
+static const uint64_t NEVER = UINT64_MAX;
+
+/** 
+ * @brief number of counts from `c` until the counter next reaches `v`,
+ * or NEVER if it can't get there
+ */
+static uint32_t counts_until(uint16_t c, uint16_t v, uint16_t tp, uint16_t max)
+{
+	if (c <= tp) {
+		if (v > c && v <= tp) return v - c;
+		if (v <= tp) return (uint32_t)(tp - c) + 1 + v;
+		return UINT32_MAX;
+	} else {
+		// above TOP, e.g. after OCRnA was lowered: count on to MAX, then wrap
+		if (v > c) return v - c;
+		return (uint32_t)(max - c) + 1 + v;
+	}
+}
+
+
+/** 
+ * @brief number of counts until timer `t` sets an interrupt flag, wraps, 
+ * or loads double buffered registers. May be early, but never late.
+ */
+static uint32_t counts_to_event(const timer_t& t)
+{
+	uint16_t tp = top(t);
+	uint16_t max = t.wide ? 0xFFFF : 0xFF;
+	uint32_t k = counts_until( t.cnt, 0, tp, max );
+	uint32_t x;
+	if ((x = counts_until( t.cnt, tp, tp, max )) < k) k = x;
+	if ((x = counts_until( t.cnt, t.ocra, tp, max )) < k) k = x;
+	if ((x = counts_until( t.cnt, t.ocrb, tp, max )) < k) k = x;
+	return k;
+}
+
+
+/// @brief clock ticks until the `k`th tick that is a multiple of `div`, given prescaler state `psc`
+static uint64_t ticks_for_counts(uint32_t k, uint16_t psc, uint16_t div)
+{
+	return (uint64_t)(div - (psc & (div-1))) + (uint64_t)(k-1) * div;
+}
+
+
+/// @brief oscillator cycles until the `m`th clk_io tick
+static uint64_t cycles_for_clkio(uint64_t m)
+{
+	uint8_t ps = s_io[A_CLKPR] & 0x0F;
+	uint64_t d = 1uLL << ps;
+	return (d - (s_cycles & (d-1))) + (m-1) * d;
+}
+
+
+/// @brief oscillator cycles until the `m`th TOSC1 tick
+static uint64_t cycles_for_tosc(uint64_t m)
+{
+	uint64_t need = m * F_CPU - s_tosc_acc;
+	return (need + F_TOSC - 1) / F_TOSC;
+}
+
+
+/** 
+ * @brief oscillator cycles until something may happen that needs detailed 
+ * simulation, at least 1
+ */
+static uint64_t cycles_to_event(void)
+{
+	if (s_clkpce) return 1;
+
+	uint64_t n = NEVER;
+	if (s_io[A_ASSR] & 0x1F) n = cycles_for_tosc(1);		// busy flags change
+	for (uint8_t i=0; i<3; i++) {
+		timer_t& t = s_t[i];
+		if (s_io[A_PRR] & _BV(t.prbit)) continue;
+		uint8_t cs = s_io[t.a_tccrb] & 7;
+		uint16_t div = (i<2) ? T01_div[cs] : T2_div[cs];
+		if (div==0) continue;
+		uint32_t k = counts_to_event(t);
+		uint64_t c;
+		if (i<2) {
+			c = cycles_for_clkio( ticks_for_counts(k, s_psc, div) );
+		} else if (s_io[A_ASSR] & _BV(AS2)) {
+			c = cycles_for_tosc( ticks_for_counts(k, t.psc, div) );
+		} else {
+			c = cycles_for_clkio( ticks_for_counts(k, t.psc, div) );
+		}
+		if (c < n) n = c;
+	}
+	return n;
+}
+
+
+/// @brief advance prescaler `psc` by `ticks`, return the number of counts for `div`
+static uint32_t advance_psc(uint16_t& psc, uint64_t ticks, uint16_t div)
+{
+	uint64_t p = psc;
+	psc = (p + ticks) & 0x3FF;
+	return div ? (uint32_t)((p + ticks) / div - p / div) : 0;
+}
+
+
+/** 
+ * @brief Advance time by `n` oscillator cycles, during which no count sets a 
+ * flag or wraps, so counters just increment.
+ */
+static void skip(uint64_t n)
+{
+	uint8_t ps = s_io[A_CLKPR] & 0x0F;
+	uint64_t ticks = ((s_cycles + n) >> ps) - (s_cycles >> ps);
+	s_cycles += n;
+	s_clkio += ticks;
+
+	for (uint8_t i=0; i<2; i++) {
+		timer_t& t = s_t[i];
+		uint16_t psc = s_psc;
+		uint32_t k = advance_psc( psc, ticks, T01_div[s_io[t.a_tccrb] & 7] );
+		if (!(s_io[A_PRR] & _BV(t.prbit))) t.cnt += k;
+	}
+	advance_psc( s_psc, ticks, 0 );
+
+	timer_t& t = s_t[2];
+	uint64_t tticks = ticks;
+	if (s_io[A_ASSR] & _BV(AS2)) {
+		uint64_t acc = s_tosc_acc + n * F_TOSC;
+		tticks = acc / F_CPU;
+		s_tosc_acc = acc % F_CPU;
+	}
+	if (!(s_io[A_PRR] & _BV(t.prbit)))
+		t.cnt += advance_psc( t.psc, tticks, T2_div[s_io[t.a_tccrb] & 7] );
+}
+
+
+/**
+ * @brief Advance simulated time by some oscillator cycles, like step(),
+ * but skip over the cycles where nothing happens.
+ */
+void fast_forward(uint64_t n)
+{
+	uint64_t end = s_cycles + n;
+	while (s_cycles < end) {
+		check_interrupts();
+		uint64_t ev = cycles_to_event();
+		uint64_t left = end - s_cycles;
+		if (ev > left) {
+			skip(left);
+			break;
+		}
+		if (ev > 1) skip(ev-1);
+		step(1);
+	}
+}
+
+
+/// @brief Advance simulated time [us], skipping over the cycles where nothing happens
+void run_fast_us(uint64_t us)
+{
+	fast_forward( us_to_cycles(us) );
+}
+
+
+/// @brief Sleep until the next interrupt has been serviced
+void sleep(void)
+{
+	s_woken = false;
+	uint64_t limit = s_cycles + 100uLL * F_CPU;		// give up after 100 s
+	while (!s_woken && s_cycles < limit) {
+		uint64_t ev = cycles_to_event();
+		if (ev > 1) skip( (ev-1 < limit-s_cycles) ? ev-1 : limit-s_cycles );
+		step(1);
+	}
+}
+
+
+/// @brief Make an interrupt pending that isn't generated by the timer model, e.g. INT0
+void raise(uint8_t vector)
+{
+	if (vector < NUM_VECTORS) s_soft_pending |= 1uL << vector;
+	check_interrupts();
+}
+
+
+/// @brief Simulated duration of each ISR call [oscillator cycles], default 0
+void set_isr_cycles(uint16_t cycles) { s_isr_cycles = cycles; }
+
+/// @brief Oscillator cycles since reset
+uint64_t cycles(void) { return s_cycles; }
+
+/// @brief Seconds since reset
+double seconds(void) { return (double)s_cycles / F_CPU; }
+
+/// @brief Number of times an interrupt vector has been executed
+uint32_t interrupts(uint8_t vector) { return vector < NUM_VECTORS ? s_count[vector] : 0; }
+
+void sei(void) { write8(A_SREG, s_io[A_SREG] | _BV(SREG_I)); }
+void cli(void) { s_io[A_SREG] &= ~_BV(SREG_I); }
+
+//---------------------------------------------------------------------------
+
+uint8_t AtomicGuard::enter(bool atomic)
+{
+	uint8_t sreg = s_io[A_SREG];
+	if (atomic) cli(); else sei();
+	return sreg;
+}
+
+
+AtomicGuard::~AtomicGuard()
+{
+	if (restore)
+		write8(A_SREG, sreg);
+	else if (atomic)
+		sei();		// ATOMIC_FORCEON
+	else
+		cli();		// NONATOMIC_FORCEOFF
+}
+
+} // namespace avrsim
@@ -0,0 +1,135 @@
+/**
+ * @file 		  AvrSim.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrSim.h $
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRSIM_H_
+#define AVRSIM_H_
+
+#include <stdint.h>
+
+/**
+ @defgroup AvrSim  <AvrSim.h>: Host simulation of ATmega328P Timer/Counters.
+ 
+ @brief Virtual register file and cycle-stepped model of Timer0, Timer1 and Timer2,
+ so that the unmodified AvrTimers library and firmware can run on a Linux host.
+
+ The headers in `host/include` replace `<avr/io.h>`, `<avr/interrupt.h>`, 
+ `<util/atomic.h>` etc. Every register is a proxy object that calls 
+ avrsim::read8() / avrsim::write8(), so reads and writes have the side 
+ effects of the real hardware (write-one-to-clear interrupt flags, double 
+ buffered compare registers, async busy flags of Timer2, ...).
+
+ Time only advances when the host calls avrsim::step(), avrsim::run_us() or 
+ their fast-forward versions, or when firmware busy-waits on `ASSR`. Interrupt service routines are called
+ synchronously from within the simulation, when their flag and enable bits 
+ are set and interrupts are enabled. ISRs take no simulated time, unless
+ avrsim::set_isr_cycles() says otherwise.
+
+ Modelled: prescalers (shared for T0/T1, separate for T2), normal, CTC and 
+ fast PWM modes, compare match and overflow flags, input capture flag in
+ mode 12, double buffered OCRnx in PWM modes, async Timer2 clocked by a 
+ 32768 Hz crystal with ASSR busy flags, PRR, and CLKPR.
+ Not modelled: phase correct PWM modes (they count like normal mode), output 
+ pins, external clock sources, other peripherals.
+
+ avrsim::fast_forward() and avrsim::run_fast_us() give the same results as
+ step() and run_us(), but jump from event to event: they compute how many 
+ cycles remain until the next count that sets an interrupt flag (or wraps 
+ the counter), advance all prescalers and counters to just before it in one 
+ go, and simulate only that cycle in detail. Time between timer interrupts 
+ costs nothing, so days or weeks of device time, e.g. past the 49.7-day wrap
+ of a 32-bit millis counter, run in seconds, as long as the interrupt rate
+ is moderate. `make fastforward` checks that both give the same results.
+
+ @{ 
+ */
+
+namespace avrsim {
+
+/// interrupt vector numbers, as in the ATmega328P datasheet
+enum Vector {
+	INT0_vect_num=1, INT1_vect_num, PCINT0_vect_num, PCINT1_vect_num, PCINT2_vect_num, 
+	WDT_vect_num, TIMER2_COMPA_vect_num, TIMER2_COMPB_vect_num, TIMER2_OVF_vect_num,
+	TIMER1_CAPT_vect_num, TIMER1_COMPA_vect_num, TIMER1_COMPB_vect_num, TIMER1_OVF_vect_num,
+	TIMER0_COMPA_vect_num, TIMER0_COMPB_vect_num, TIMER0_OVF_vect_num, SPI_STC_vect_num,
+	USART_RX_vect_num, USART_UDRE_vect_num, USART_TX_vect_num, ADC_vect_num, 
+	EE_READY_vect_num, ANALOG_COMP_vect_num, TWI_vect_num, SPM_READY_vect_num,
+	NUM_VECTORS
+};
+
+void reset(uint8_t mcusr=0x01);
+uint8_t read8(uint8_t addr);
+void write8(uint8_t addr, uint8_t value);
+uint16_t read16(uint8_t addr);
+void write16(uint8_t addr, uint16_t value);
+
+void step(uint64_t cycles=1);
+void run_us(uint64_t us);
+void fast_forward(uint64_t cycles);
+void run_fast_us(uint64_t us);
+void sleep(void);
+void raise(uint8_t vector);
+void set_isr_cycles(uint16_t cycles);
+
+uint64_t cycles(void);
+double seconds(void);
+uint32_t interrupts(uint8_t vector);
+
+void sei(void);
+void cli(void);
+
+
+/// proxy for an 8-bit I/O register
+struct Reg8 {
+	uint8_t a;
+	operator uint8_t() const { return read8(a); }
+	Reg8& operator=(uint8_t v) { write8(a,v); return *this; }
+	Reg8& operator=(const Reg8& r) { write8(a,(uint8_t)r); return *this; }
+	Reg8& operator|=(uint8_t v) { write8(a,read8(a)|v); return *this; }
+	Reg8& operator&=(uint8_t v) { write8(a,read8(a)&v); return *this; }
+	Reg8& operator^=(uint8_t v) { write8(a,read8(a)^v); return *this; }
+};
+
+/// proxy for a 16-bit I/O register
+struct Reg16 {
+	uint8_t a;
+	operator uint16_t() const { return read16(a); }
+	Reg16& operator=(uint16_t v) { write16(a,v); return *this; }
+	Reg16& operator=(const Reg16& r) { write16(a,(uint16_t)r); return *this; }
+	Reg16& operator|=(uint16_t v) { write16(a,read16(a)|v); return *this; }
+	Reg16& operator&=(uint16_t v) { write16(a,read16(a)&v); return *this; }
+};
+
+/// @brief saves and restores the I flag, for ATOMIC_BLOCK
+struct AtomicGuard {
+	uint8_t sreg;
+	bool atomic;
+	bool restore;
+	bool done;
+	// inline, so the compiler can see that the ATOMIC_BLOCK body runs exactly once
+	AtomicGuard(bool atomic_, bool restorestate) : 
+		sreg(enter(atomic_)), atomic(atomic_), restore(restorestate), done(false) {}
+	static uint8_t enter(bool atomic);
+	~AtomicGuard();
+	bool once() { bool r = !done; done = true; return r; }
+};
+
+} // namespace avrsim
+
+/** @} */
+
+#endif // AVRSIM_H_
@@ -0,0 +1,65 @@
+/**
+ * @file 		  example_main.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Run the firmware in examples/avr on the host, and report what the timers did.
+ *
+ * The firmware's main() is compiled as firmware_main(). It sets up the timers
+ * and returns, so after that we enable interrupts, let simulated time pass, 
+ * and print the counters maintained by the firmware and the library.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "AvrSim.h"
+#include "AvrUART.h"
+#include "AvrTimers.h"
+
+int firmware_main();
+
+AvrUART0 uart0;
+
+extern AvrTimer0 timer0;
+extern AvrTimer1 timer1;
+extern AvrTimer2 timer2;
+extern volatile unsigned long my_millis;
+extern volatile unsigned long my_seconds;
+
+
+int main(int argc, char* argv[])
+{
+	uint32_t seconds = (argc > 1) ? strtoul(argv[1],NULL,0) : 10;
+
+	avrsim::reset();
+	firmware_main();
+	sei();
+
+	for (uint32_t s=1; s<=seconds; s++) {
+		avrsim::run_us( 1000000uLL );
+		printf("t=%3lu s  T0 %8lu ms %11lu us  T1 %8lu ms  T2 %8lu ms  my_seconds %lu  my_millis %lu\n",
+			(unsigned long)s,
+			(unsigned long)timer0.get_millis(), (unsigned long)timer0.get_micros(),
+			(unsigned long)timer1.get_millis(), (unsigned long)timer2.get_millis(),
+			(unsigned long)my_seconds, (unsigned long)my_millis );
+	}
+	printf("interrupts: T0 COMPA %lu, T1 OVF %lu, T2 COMPA %lu\n",
+		(unsigned long)avrsim::interrupts(avrsim::TIMER0_COMPA_vect_num),
+		(unsigned long)avrsim::interrupts(avrsim::TIMER1_OVF_vect_num),
+		(unsigned long)avrsim::interrupts(avrsim::TIMER2_COMPA_vect_num) );
+	return 0;
+}
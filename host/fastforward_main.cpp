@@ -0,0 +1,141 @@
+/**
+ * @file 		  fastforward_main.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Check that avrsim::run_fast_us() gives the same results as avrsim::run_us().
+ *
+ * The same firmware runs twice from reset, once cycle by cycle, once fast-
+ * forwarding from event to event: Timer0 at 1 kHz with a task, Timer1 at
+ * 100 Hz maintaining `millis()`, Timer2 in async mode from the watch crystal.
+ * Time advances in steps of varying length, and after each step the interrupt
+ * counts, task calls, millis and counter values of both runs must be equal.
+ * Exit code is 0 if all checks passed.
+ */
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "AvrSim.h"
+#include "AvrUART.h"
+#include "AvrTimers.h"
+
+AvrUART0 uart0;
+
+AvrTimer0 timer0;
+AvrTimer1 timer1;
+AvrTimer2 timer2;
+
+volatile uint32_t t0_calls = 0;
+volatile uint32_t t2_calls = 0;
+
+void t0_cb( void* ) { t0_calls++; }
+void t2_cb( void* ) { t2_calls++; }
+
+static int s_errors = 0;
+
+#define CHECK(cond, ...) \
+	do { if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); s_errors++; } } while (0)
+
+/// what is compared after each step, relative to the start of the run
+struct sample_t {
+	uint64_t cycles;
+	uint32_t ints[3];
+	uint32_t t0_calls, t2_calls;
+	uint32_t millis;
+	uint8_t  tcnt0, tcnt2;
+	uint16_t tcnt1;
+};
+
+static const int STEPS = 200;
+static sample_t s_samples[2][STEPS];
+
+
+static void run(int fast)
+{
+	static bool first = true;
+
+	avrsim::reset();
+	uint32_t m0 = millis();
+	uint32_t c0 = t0_calls, c2 = t2_calls;
+
+	timer0.begin( 1000 );
+	timer1.handle_millis();
+	timer1.begin( 100 );
+	timer2.begin( 64, 0, NULL, 32768uL, true );
+	if (first) {
+		timer0.add_task( 7, t0_cb );
+		timer2.add_task( 3, t2_cb );
+		first = false;
+	}
+	timer0.start();
+	timer1.start();
+	timer2.start();
+	sei();
+
+	srand(1);
+	for (int i=0; i<STEPS; i++) {
+		uint64_t us = 1 + rand() % 20000;
+		if (fast)
+			avrsim::run_fast_us( us );
+		else
+			avrsim::run_us( us );
+		sample_t& s = s_samples[fast][i];
+		s.cycles = avrsim::cycles();
+		s.ints[0] = avrsim::interrupts(avrsim::TIMER0_COMPA_vect_num);
+		s.ints[1] = avrsim::interrupts(avrsim::TIMER1_OVF_vect_num);
+		s.ints[2] = avrsim::interrupts(avrsim::TIMER2_COMPA_vect_num);
+		s.t0_calls = t0_calls - c0;
+		s.t2_calls = t2_calls - c2;
+		s.millis = millis() - m0;
+		s.tcnt0 = TCNT0;
+		s.tcnt1 = TCNT1;
+		s.tcnt2 = TCNT2;
+	}
+	cli();
+}
+
+
+int main(int argc, char* argv[])
+{
+	run(0);
+	run(1);
+
+	for (int i=0; i<STEPS; i++) {
+		const sample_t& a = s_samples[0][i];
+		const sample_t& b = s_samples[1][i];
+		if (memcmp( &a, &b, sizeof(a) ) == 0) continue;
+		CHECK( false, "step %d at %llu/%llu cycles: interrupts %lu/%lu %lu/%lu %lu/%lu, "
+			"tasks %lu/%lu %lu/%lu, millis %lu/%lu, TCNT %u/%u %u/%u %u/%u",
+			i, (unsigned long long)a.cycles, (unsigned long long)b.cycles,
+			(unsigned long)a.ints[0], (unsigned long)b.ints[0],
+			(unsigned long)a.ints[1], (unsigned long)b.ints[1],
+			(unsigned long)a.ints[2], (unsigned long)b.ints[2],
+			(unsigned long)a.t0_calls, (unsigned long)b.t0_calls,
+			(unsigned long)a.t2_calls, (unsigned long)b.t2_calls,
+			(unsigned long)a.millis, (unsigned long)b.millis,
+			a.tcnt0, b.tcnt0, a.tcnt1, b.tcnt1, a.tcnt2, b.tcnt2 );
+		break;
+	}
+
+	const sample_t& s = s_samples[1][STEPS-1];
+	printf("%s: %d steps, %.3f s, interrupts T0 %lu, T1 %lu, T2 %lu, millis %lu\n",
+		s_errors ? "FAILED" : "passed", STEPS, (double)s.cycles / F_CPU,
+		(unsigned long)s.ints[0], (unsigned long)s.ints[1], (unsigned long)s.ints[2],
+		(unsigned long)s.millis );
+	return s_errors ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file 		  idlescale_main.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Check that AVRTIMERS_IDLE_SCALING does not gain or lose time.
+ *
+ * Timer1 interrupts at 1 kHz and maintains `millis()`. A task every 10 ms
+ * lets the rate drop to 100 Hz, a task every 1 ms is enabled and disabled
+ * at random moments, which switches the rate back and forth. PWM output and
+ * a new begin() must restore the nominal rate. Timer2 does the same with a
+ * per-interrupt function. `millis()` is compared with simulated time.
+ * Build with `make idlescale`, exit code is 0 if all checks passed.
+ */
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "AvrSim.h"
+#include "AvrUART.h"
+#include "AvrTimers.h"
+
+#if !AVRTIMERS_IDLE_SCALING
+ #error "build with -DAVRTIMERS_IDLE_SCALING=1, see 'make idlescale'"
+#endif
+
+AvrUART0 uart0;
+
+AvrTimer1 timer1;
+AvrTimer2 timer2;
+
+volatile uint32_t fast_calls = 0;
+volatile uint32_t slow_calls = 0;
+volatile uint32_t t2_calls = 0;
+
+void fast_cb( void* ) { fast_calls++; }
+void slow_cb( void* ) { slow_calls++; }
+void t2_cb( void* ) { t2_calls++; }
+void t2_isr( void ) { }
+
+static int s_errors = 0;
+
+#define CHECK(cond, ...) \
+	do { if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); s_errors++; } } while (0)
+
+static uint64_t s_t0;
+
+/// simulated time since start [ms]
+static uint32_t vms(void) { return (avrsim::cycles() - s_t0) / (F_CPU / 1000uL); }
+
+/// millis() minus simulated time, which may be one tick of 10 ms behind
+static void check_time(const char* what)
+{
+	int32_t drift = (int32_t)(millis() - vms());
+	CHECK( drift <= 0 && drift > -10, "%s: millis off by %ld ms", what, (long)drift );
+}
+
+
+int main(int argc, char* argv[])
+{
+	uint32_t toggles = (argc > 1) ? strtoul(argv[1],NULL,0) : 20000;
+
+	avrsim::reset();
+	avrsim::set_isr_cycles( 100 );		// time to enter the ISR and call_tasks()
+	srand(1);
+
+	timer1.handle_millis();
+	timer1.begin( 1000 );
+	uint8_t fast = timer1.add_task( 1, fast_cb );
+	timer1.add_task( 10, slow_cb );
+	timer1.start();
+	sei();
+	s_t0 = avrsim::cycles();
+
+	// 1 kHz while the fast task is enabled, 100 Hz while it is disabled
+	uint32_t on_ms = 0;
+	bool on = true;
+	for (uint32_t i=0; i<toggles; i++) {
+		uint32_t us = 100 + rand() % 30000;
+		uint32_t n = fast_calls;
+		avrsim::run_fast_us( us );
+		if (on) {
+			on_ms += us / 1000;
+			// the first ms of a period may still run at the lower rate
+			CHECK( fast_calls - n + 10 >= us / 1000,
+				"fast task ran %lu times in %lu us", (unsigned long)(fast_calls - n), (unsigned long)us );
+		} else {
+			CHECK( fast_calls == n, "disabled task ran" );
+		}
+		on = !on;
+		timer1.enable_task( fast, on );
+	}
+	check_time( "toggled tasks" );
+	CHECK( slow_calls + 1 >= vms() / 10 && slow_calls <= vms() / 10,
+		"slow task ran %lu times in %lu ms", (unsigned long)slow_calls, (unsigned long)vms() );
+	uint32_t ints = avrsim::interrupts(avrsim::TIMER1_OVF_vect_num);
+	printf("T1: %lu ms, %lu interrupts, fast task %lu calls in %lu ms\n",
+		(unsigned long)vms(), (unsigned long)ints, (unsigned long)fast_calls, (unsigned long)on_ms );
+	CHECK( ints < vms(), "rate was never lowered" );
+
+	// PWM needs the nominal rate, even with only the slow task
+	timer1.enable_task( fast, false );
+	avrsim::run_fast_us( 50000 );
+	CHECK( ICR1 == 10*(F_CPU/1000/8)-1, "T1 rate not lowered, ICR1=%u", (unsigned)ICR1 );
+	timer1.setPWM_A( 100, 1000 );
+	avrsim::run_fast_us( 20000 );
+	CHECK( ICR1 == (F_CPU/1000)-1, "T1 rate not restored for PWM, ICR1=%u", (unsigned)ICR1 );
+	timer1.enable_task( fast, true );
+	timer1.enable_task( fast, false );
+	avrsim::run_fast_us( 20000 );
+	CHECK( ICR1 == (F_CPU/1000)-1, "T1 rate lowered during PWM, ICR1=%u", (unsigned)ICR1 );
+	timer1.setPWM_A( 0, 1000 );
+	avrsim::run_fast_us( 20000 );
+	CHECK( ICR1 == 10*(F_CPU/1000/8)-1, "T1 rate not lowered after PWM, ICR1=%u", (unsigned)ICR1 );
+	check_time( "PWM" );
+
+	// begin() again starts at the nominal rate, with consistent task scales
+	uint32_t n = slow_calls;
+	timer1.begin( 1000 );
+	timer1.start();
+	avrsim::run_fast_us( 1000000 );
+	CHECK( slow_calls - n >= 99 && slow_calls - n <= 101,
+		"slow task ran %lu times in 1 s after begin()", (unsigned long)(slow_calls - n) );
+
+	// Timer2 keeps the nominal rate while it has a per-interrupt function
+	timer2.begin( 1000, 0, t2_isr );
+	timer2.add_task( 8, t2_cb );
+	timer2.start();
+	uint32_t i2 = avrsim::interrupts(avrsim::TIMER2_COMPA_vect_num);
+	avrsim::run_fast_us( 100000 );
+	i2 = avrsim::interrupts(avrsim::TIMER2_COMPA_vect_num) - i2;
+	CHECK( i2 >= 99 && i2 <= 101, "T2 had %lu interrupts in 100 ms with m_isr", (unsigned long)i2 );
+	timer2.begin( 1000 );
+	timer2.start();
+	avrsim::run_fast_us( 20000 );		// the rate drops when the task is due
+	i2 = avrsim::interrupts(avrsim::TIMER2_COMPA_vect_num);
+	avrsim::run_fast_us( 100000 );
+	i2 = avrsim::interrupts(avrsim::TIMER2_COMPA_vect_num) - i2;
+	CHECK( i2 >= 12 && i2 <= 13, "T2 had %lu interrupts in 100 ms without m_isr", (unsigned long)i2 );
+
+	printf("%s\n", s_errors ? "FAILED" : "passed");
+	return s_errors ? 1 : 0;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file 		  AvrUART.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Host replacement for the AvrUART library, used by the example firmware.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRUART_H_
+#define AVRUART_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/// UART0, output goes to stdout
+class AvrUART0 {
+public:
+	void begin(uint32_t baud) { (void)baud; }
+	void put(char c) { putchar(c); }
+	void puts(const char* s) { fputs(s,stdout); }
+};
+
+#endif // AVRUART_H_
@@ -0,0 +1,44 @@
+/**
+ * @file 		  avr/interrupt.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Host replacement for <avr/interrupt.h>: ISRs are plain functions called by the simulator.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRSIM_INTERRUPT_H_
+#define AVRSIM_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define sei()	avrsim::sei()
+#define cli()	avrsim::cli()
+#define reti()	return
+
+// ISR attributes have no meaning on the host
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+#define ISR_FLATTEN
+#define ISR_NOICF
+#define ISR_ALIASOF(v)
+
+#define ISR(vector, ...) \
+	extern "C" void vector(void) __attribute__((used)); \
+	extern "C" void vector(void)
+
+#define EMPTY_INTERRUPT(vector) \
+	extern "C" void vector(void) __attribute__((used)); \
+	extern "C" void vector(void) {}
+
+#endif // AVRSIM_INTERRUPT_H_
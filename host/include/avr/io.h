@@ -0,0 +1,261 @@
+/**
+ * @file 		  avr/io.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Host replacement for <avr/io.h>: ATmega328P registers as simulator proxies.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRSIM_IO_H_
+#define AVRSIM_IO_H_
+
+#include <stdint.h>
+#include "AvrSim.h"
+
+#define __AVR_ATmega328P__ 1
+
+#define _BV(bit) (1 << (bit))
+#define _SFR_MEM8(a)	(avrsim::Reg8{a})
+#define _SFR_MEM16(a)	(avrsim::Reg16{a})
+
+#define RAMSTART	0x100
+#define RAMEND		0x8FF
+#define FLASHEND	0x7FFF
+
+// ----- ports
+
+#define PINB	_SFR_MEM8(0x23)
+#define DDRB	_SFR_MEM8(0x24)
+#define PORTB	_SFR_MEM8(0x25)
+#define PINC	_SFR_MEM8(0x26)
+#define DDRC	_SFR_MEM8(0x27)
+#define PORTC	_SFR_MEM8(0x28)
+#define PIND	_SFR_MEM8(0x29)
+#define DDRD	_SFR_MEM8(0x2A)
+#define PORTD	_SFR_MEM8(0x2B)
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+// ----- interrupt flags and masks
+
+#define TIFR0	_SFR_MEM8(0x35)
+#define TOV0	0
+#define OCF0A	1
+#define OCF0B	2
+#define TIFR1	_SFR_MEM8(0x36)
+#define TOV1	0
+#define OCF1A	1
+#define OCF1B	2
+#define ICF1	5
+#define TIFR2	_SFR_MEM8(0x37)
+#define TOV2	0
+#define OCF2A	1
+#define OCF2B	2
+#define EIFR	_SFR_MEM8(0x3C)
+#define INTF0	0
+#define INTF1	1
+#define EIMSK	_SFR_MEM8(0x3D)
+#define INT0	0
+#define INT1	1
+#define TIMSK0	_SFR_MEM8(0x6E)
+#define TOIE0	0
+#define OCIE0A	1
+#define OCIE0B	2
+#define TIMSK1	_SFR_MEM8(0x6F)
+#define TOIE1	0
+#define OCIE1A	1
+#define OCIE1B	2
+#define ICIE1	5
+#define TIMSK2	_SFR_MEM8(0x70)
+#define TOIE2	0
+#define OCIE2A	1
+#define OCIE2B	2
+#define EICRA	_SFR_MEM8(0x69)
+
+// ----- general purpose I/O registers
+
+#define GPIOR0	_SFR_MEM8(0x3E)
+#define GPIOR1	_SFR_MEM8(0x4A)
+#define GPIOR2	_SFR_MEM8(0x4B)
+
+// ----- Timer/Counter0
+
+#define GTCCR	_SFR_MEM8(0x43)
+#define PSRSYNC	0
+#define PSRASY	1
+#define TSM		7
+#define TCCR0A	_SFR_MEM8(0x44)
+#define WGM00	0
+#define WGM01	1
+#define COM0B0	4
+#define COM0B1	5
+#define COM0A0	6
+#define COM0A1	7
+#define TCCR0B	_SFR_MEM8(0x45)
+#define CS00	0
+#define CS01	1
+#define CS02	2
+#define WGM02	3
+#define FOC0B	6
+#define FOC0A	7
+#define TCNT0	_SFR_MEM8(0x46)
+#define OCR0A	_SFR_MEM8(0x47)
+#define OCR0B	_SFR_MEM8(0x48)
+
+// ----- system
+
+#define SMCR	_SFR_MEM8(0x53)
+#define SE		0
+#define SM0		1
+#define SM1		2
+#define SM2		3
+#define MCUSR	_SFR_MEM8(0x54)
+#define PORF	0
+#define EXTRF	1
+#define BORF	2
+#define WDRF	3
+#define MCUCR	_SFR_MEM8(0x55)
+#define SPL		_SFR_MEM8(0x5D)
+#define SPH		_SFR_MEM8(0x5E)
+#define SP		_SFR_MEM16(0x5D)
+#define SREG	_SFR_MEM8(0x5F)
+#define SREG_I	7
+#define WDTCSR	_SFR_MEM8(0x60)
+#define WDP0	0
+#define WDP1	1
+#define WDP2	2
+#define WDE		3
+#define WDCE	4
+#define WDP3	5
+#define WDIE	6
+#define WDIF	7
+#define CLKPR	_SFR_MEM8(0x61)
+#define CLKPS0	0
+#define CLKPCE	7
+#define PRR		_SFR_MEM8(0x64)
+#define PRADC	0
+#define PRUSART0 1
+#define PRSPI	2
+#define PRTIM1	3
+#define PRTIM0	5
+#define PRTIM2	6
+#define PRTWI	7
+
+// ----- Timer/Counter1
+
+#define TCCR1A	_SFR_MEM8(0x80)
+#define WGM10	0
+#define WGM11	1
+#define COM1B0	4
+#define COM1B1	5
+#define COM1A0	6
+#define COM1A1	7
+#define TCCR1B	_SFR_MEM8(0x81)
+#define CS10	0
+#define CS11	1
+#define CS12	2
+#define WGM12	3
+#define WGM13	4
+#define ICES1	6
+#define ICNC1	7
+#define TCCR1C	_SFR_MEM8(0x82)
+#define TCNT1	_SFR_MEM16(0x84)
+#define ICR1	_SFR_MEM16(0x86)
+#define OCR1A	_SFR_MEM16(0x88)
+#define OCR1B	_SFR_MEM16(0x8A)
+
+// ----- Timer/Counter2
+
+#define TCCR2A	_SFR_MEM8(0xB0)
+#define WGM20	0
+#define WGM21	1
+#define COM2B0	4
+#define COM2B1	5
+#define COM2A0	6
+#define COM2A1	7
+#define TCCR2B	_SFR_MEM8(0xB1)
+#define CS20	0
+#define CS21	1
+#define CS22	2
+#define WGM22	3
+#define FOC2B	6
+#define FOC2A	7
+#define TCNT2	_SFR_MEM8(0xB2)
+#define OCR2A	_SFR_MEM8(0xB3)
+#define OCR2B	_SFR_MEM8(0xB4)
+#define ASSR	_SFR_MEM8(0xB6)
+#define TCR2BUB	0
+#define TCR2AUB	1
+#define OCR2BUB	2
+#define OCR2AUB	3
+#define TCN2UB	4
+#define AS2		5
+#define EXCLK	6
+
+// ----- USART0
+
+#define UCSR0A	_SFR_MEM8(0xC0)
+#define UDRE0	5
+#define UCSR0B	_SFR_MEM8(0xC1)
+#define UDR0	_SFR_MEM8(0xC6)
+
+// ----- interrupt vectors
+
+#define INT0_vect			__vector_1
+#define INT1_vect			__vector_2
+#define PCINT0_vect			__vector_3
+#define PCINT1_vect			__vector_4
+#define PCINT2_vect			__vector_5
+#define WDT_vect			__vector_6
+#define TIMER2_COMPA_vect	__vector_7
+#define TIMER2_COMPB_vect	__vector_8
+#define TIMER2_OVF_vect		__vector_9
+#define TIMER1_CAPT_vect	__vector_10
+#define TIMER1_COMPA_vect	__vector_11
+#define TIMER1_COMPB_vect	__vector_12
+#define TIMER1_OVF_vect		__vector_13
+#define TIMER0_COMPA_vect	__vector_14
+#define TIMER0_COMPB_vect	__vector_15
+#define TIMER0_OVF_vect		__vector_16
+#define SPI_STC_vect		__vector_17
+#define USART_RX_vect		__vector_18
+#define USART_UDRE_vect		__vector_19
+#define USART_TX_vect		__vector_20
+#define ADC_vect			__vector_21
+#define EE_READY_vect		__vector_22
+#define ANALOG_COMP_vect	__vector_23
+#define TWI_vect			__vector_24
+#define SPM_READY_vect		__vector_25
+
+#endif // AVRSIM_IO_H_
@@ -0,0 +1,36 @@
+/**
+ * @file 		  avr/pgmspace.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Host replacement for <avr/pgmspace.h>: flash is ordinary memory.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRSIM_PGMSPACE_H_
+#define AVRSIM_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P				const char*
+#define PSTR(s)				(s)
+#define pgm_read_byte(p)	(*(const uint8_t*)(p))
+#define pgm_read_word(p)	(*(const uint16_t*)(p))
+#define pgm_read_dword(p)	(*(const uint32_t*)(p))
+#define pgm_read_ptr(p)		(*(void* const*)(p))
+#define strlen_P			strlen
+#define strcpy_P			strcpy
+#define memcpy_P			memcpy
+
+#endif // AVRSIM_PGMSPACE_H_
@@ -0,0 +1,37 @@
+/**
+ * @file 		  avr/sleep.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Host replacement for <avr/sleep.h>: sleeping advances simulated time to the next interrupt.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRSIM_SLEEP_H_
+#define AVRSIM_SLEEP_H_
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE			(0)
+#define SLEEP_MODE_ADC			_BV(SM0)
+#define SLEEP_MODE_PWR_DOWN		_BV(SM1)
+#define SLEEP_MODE_PWR_SAVE		(_BV(SM0) | _BV(SM1))
+#define SLEEP_MODE_STANDBY		(_BV(SM1) | _BV(SM2))
+#define SLEEP_MODE_EXT_STANDBY	(_BV(SM0) | _BV(SM1) | _BV(SM2))
+
+#define set_sleep_mode(mode)	(SMCR = (SMCR & ~(_BV(SM0)|_BV(SM1)|_BV(SM2))) | (mode))
+#define sleep_enable()			(SMCR |= _BV(SE))
+#define sleep_disable()			(SMCR &= ~_BV(SE))
+#define sleep_cpu()				avrsim::sleep()
+#define sleep_mode()			avrsim::sleep()
+
+#endif // AVRSIM_SLEEP_H_
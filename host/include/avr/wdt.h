@@ -0,0 +1,39 @@
+/**
+ * @file 		  avr/wdt.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Host replacement for <avr/wdt.h>: only sets WDTCSR, the watchdog is not simulated.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRSIM_WDT_H_
+#define AVRSIM_WDT_H_
+
+#include <avr/io.h>
+
+#define WDTO_15MS	0
+#define WDTO_30MS	1
+#define WDTO_60MS	2
+#define WDTO_120MS	3
+#define WDTO_250MS	4
+#define WDTO_500MS	5
+#define WDTO_1S		6
+#define WDTO_2S		7
+#define WDTO_4S		8
+#define WDTO_8S		9
+
+#define wdt_reset()			do {} while (0)
+#define wdt_enable(value)	(WDTCSR = _BV(WDE) | ((value) & 7) | (((value) & 8) << 2))
+#define wdt_disable()		(WDTCSR = 0)
+
+#endif // AVRSIM_WDT_H_
@@ -0,0 +1,27 @@
+/**
+ * @file 		  debugstream.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Host replacement for the debugstream library: debug output goes to stderr.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef DEBUGSTREAM_H_
+#define DEBUGSTREAM_H_
+
+#include <stdio.h>
+
+#define DEBUG_PRINT(s)			fputs( (s), stderr )
+#define DEBUG_PRINTF(fmt,...)	fprintf( stderr, (fmt), ##__VA_ARGS__ )
+
+#endif // DEBUGSTREAM_H_
@@ -0,0 +1,39 @@
+/**
+ * @file 		  stdpins.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Host replacement for the stdpins.h pin macro library, just enough for AvrTimers.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef STDPINS_H_
+#define STDPINS_H_
+
+#include <avr/io.h>
+
+#define ACTIVE_HIGH	1
+#define ACTIVE_LOW	0
+
+// pin descriptors: port letter, bit, polarity
+#define _OC0A(pol)	D,6,pol
+#define _OC0B(pol)	D,5,pol
+#define _OC1A(pol)	B,1,pol
+#define _OC1B(pol)	B,2,pol
+#define _OC2A(pol)	B,3,pol
+#define _OC2B(pol)	D,3,pol
+
+#define _SET(port,bit,pol,val) \
+	do { if (val) PORT##port |= _BV(bit); else PORT##port &= ~_BV(bit); } while (0)
+#define SET(pin,val)	_SET(pin,val)
+
+#endif // STDPINS_H_
@@ -0,0 +1,34 @@
+/**
+ * @file 		  util/atomic.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Host replacement for <util/atomic.h>, using the simulated I flag.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRSIM_ATOMIC_H_
+#define AVRSIM_ATOMIC_H_
+
+#include "AvrSim.h"
+
+#define ATOMIC_RESTORESTATE		true
+#define ATOMIC_FORCEON			false
+#define NONATOMIC_RESTORESTATE	true
+#define NONATOMIC_FORCEOFF		false
+
+#define ATOMIC_BLOCK(type) \
+	for (avrsim::AtomicGuard _atomic_guard(true, type); _atomic_guard.once(); )
+#define NONATOMIC_BLOCK(type) \
+	for (avrsim::AtomicGuard _atomic_guard(false, type); _atomic_guard.once(); )
+
+#endif // AVRSIM_ATOMIC_H_
@@ -0,0 +1,119 @@
+/**
+ * @file 		  jitter_main.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Check the random task periods of AVRTIMERS_JITTER.
+ *
+ * A task on Timer0 or Timer1 runs with jitter, and the time between its 
+ * calls is measured in simulated cycles. Every period must be within
+ * [period-jitter, period+jitter] and the average must be `period`, for
+ * both distributions, and for jitter values that set_jitter() must limit.
+ * Build with `make jitter`, exit code is 0 if all checks passed.
+ */
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "AvrSim.h"
+#include "AvrUART.h"
+#include "AvrTimers.h"
+
+#if !AVRTIMERS_JITTER
+ #error "build with -DAVRTIMERS_JITTER=1, see 'make jitter'"
+#endif
+
+AvrUART0 uart0;
+
+AvrTimer0 timer0;
+AvrTimer1 timer1;
+
+static int s_errors = 0;
+
+#define CHECK(cond, ...) \
+	do { if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); s_errors++; } } while (0)
+
+static const uint32_t RATE = 1000;			// timer ticks per second
+
+static uint64_t s_last;						// cycles at the previous call
+static uint32_t s_calls, s_min, s_max;
+static double   s_sum;
+
+void jitter_cb( void* )
+{
+	uint64_t now = avrsim::cycles();
+	if (s_last) {
+		uint32_t ticks = (now - s_last + F_CPU/RATE/2) / (F_CPU/RATE);
+		if (ticks < s_min) s_min = ticks;
+		if (ticks > s_max) s_max = ticks;
+		s_sum += ticks;
+		s_calls++;
+	}
+	s_last = now;
+}
+
+
+/**
+ * @brief run a task with `period` and `jitter` for `n` periods, check the range
+ * `expect` of the jitter after limiting, and the average period
+ */
+static void check(AvrTimerBase& timer, uint16_t period, uint16_t jitter, AvrTimerBase::Jitter dist, uint16_t expect, uint32_t n)
+{
+	s_last = 0;
+	s_calls = 0;
+	s_min = UINT32_MAX;
+	s_max = 0;
+	s_sum = 0;
+
+	uint8_t t = timer.add_task( period, jitter_cb );
+	timer.set_jitter( t, jitter, dist );
+	avrsim::run_fast_us( (uint64_t)period * (n+1) * (1000000uL/RATE) );
+	timer.enable_task( t, false );
+
+	double avg = s_sum / s_calls;
+	// the average of n periods with a uniform distribution has a standard deviation of jitter/sqrt(3n)
+	double tol = 5.0 * expect / sqrt(3.0 * s_calls) + 0.5;
+	printf("period %5u jitter %5u %s: %lu periods %lu..%lu, average %.1f\n",
+		period, jitter, dist ? "triangular" : "uniform", (unsigned long)s_calls,
+		(unsigned long)s_min, (unsigned long)s_max, avg );
+	CHECK( s_min >= (uint32_t)period - expect && s_max <= (uint32_t)period + expect,
+		"periods %lu..%lu outside %u+-%u", (unsigned long)s_min, (unsigned long)s_max, period, expect );
+	CHECK( s_max - s_min > expect, "periods %lu..%lu don't cover %u+-%u",
+		(unsigned long)s_min, (unsigned long)s_max, period, expect );
+	CHECK( fabs(avg - period) < tol, "average period %.1f, expected %u", avg, period );
+}
+
+
+int main(int argc, char* argv[])
+{
+	avrsim::reset();
+	timer0.begin( RATE );
+	timer0.start();
+	timer1.begin( RATE );
+	timer1.start();
+	sei();
+	AvrTimerBase::seed_jitter( 12345 );
+
+	check( timer1, 100, 50, AvrTimerBase::JitterUniform, 50, 10000 );
+	check( timer1, 100, 50, AvrTimerBase::JitterTriangular, 50, 10000 );
+	check( timer1, 10, 20, AvrTimerBase::JitterUniform, 9, 10000 );			// limited to period-1
+	check( timer1, 60000, 40000, AvrTimerBase::JitterUniform, 5535, 300 );	// limited to 65535-period
+	check( timer0, 40000, 40000, AvrTimerBase::JitterTriangular, 25535, 300 );
+
+	printf("%s\n", s_errors ? "FAILED" : "passed");
+	return s_errors ? 1 : 0;
+}
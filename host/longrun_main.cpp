@@ -0,0 +1,103 @@
+/**
+ * @file 		  longrun_main.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Run timers for weeks of simulated time, check millis, tasks and drift.
+ *
+ * Timer1 interrupts at 10 Hz and maintains `millis()`, a task counts seconds.
+ * Timer2 runs in async mode from the watch crystal at 1 Hz, with its own task.
+ * The simulation fast-forwards from interrupt to interrupt, so 50 days, past 
+ * the wrap of the 32-bit millis counter at 49.7 days, take a few seconds.
+ * Exit code is 0 if all checks passed.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "AvrSim.h"
+#include "AvrUART.h"
+#include "AvrTimers.h"
+
+AvrUART0 uart0;
+
+AvrTimer1 timer1;
+AvrTimer2 timer2;
+
+volatile uint32_t t1_seconds = 0;
+volatile uint32_t t2_seconds = 0;
+
+void t1_cb( void* ) { t1_seconds++; }
+void t2_cb( void* ) { t2_seconds++; }
+
+static int s_errors = 0;
+
+#define CHECK(cond, ...) \
+	do { if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); s_errors++; } } while (0)
+
+
+int main(int argc, char* argv[])
+{
+	uint32_t days = (argc > 1) ? strtoul(argv[1],NULL,0) : 50;
+	const uint64_t DAY_MS = 24uLL * 3600uLL * 1000uLL;
+
+	avrsim::reset();
+
+	timer1.handle_millis();
+	timer1.begin( 10 );
+	timer1.add_task( 10, t1_cb );
+	timer1.start();
+
+	timer2.begin( 1, 0, NULL, 32768uL, true );
+	timer2.add_task( 1, t2_cb );
+	timer2.start();
+	sei();
+
+	uint64_t t0 = avrsim::cycles();
+	uint32_t prev = millis();
+	bool wrapped = false;
+
+	for (uint32_t d=1; d<=days; d++) {
+		avrsim::run_fast_us( DAY_MS * 1000uLL );
+
+		uint64_t vms = (avrsim::cycles() - t0) / (F_CPU / 1000uL);	// virtual time [ms]
+		uint32_t ms = millis();
+		if (ms < prev) wrapped = true;
+		prev = ms;
+		int32_t drift = (int32_t)(ms - (uint32_t)vms);
+		int32_t drift2 = (int32_t)(timer2.get_millis() - (uint32_t)vms);
+
+		printf("day %3lu  millis %10lu  drift %4ld ms  T2 drift %4ld ms  tasks %lu %lu\n",
+			(unsigned long)d, (unsigned long)ms, (long)drift, (long)drift2, 
+			(unsigned long)t1_seconds, (unsigned long)t2_seconds );
+
+		// millis runs in 100 ms steps, T2 in 1 s steps
+		CHECK( drift <= 0 && drift > -100, "T1 millis off by %ld ms on day %lu", (long)drift, (unsigned long)d );
+		CHECK( drift2 <= 0 && drift2 > -1000, "T2 millis off by %ld ms on day %lu", (long)drift2, (unsigned long)d );
+		CHECK( t1_seconds == vms/1000 || t1_seconds+1 == vms/1000, 
+			"T1 task ran %lu times after %llu s", (unsigned long)t1_seconds, (unsigned long long)(vms/1000) );
+		CHECK( t2_seconds == vms/1000 || t2_seconds+1 == vms/1000, 
+			"T2 task ran %lu times after %llu s", (unsigned long)t2_seconds, (unsigned long long)(vms/1000) );
+	}
+	if (days * DAY_MS > 0xFFFFFFFFuLL)
+		CHECK( wrapped, "millis did not wrap" );
+
+	printf("%s: %lu days, %lu T1 interrupts, %lu T2 interrupts\n", 
+		s_errors ? "FAILED" : "passed", (unsigned long)days,
+		(unsigned long)avrsim::interrupts(avrsim::TIMER1_OVF_vect_num),
+		(unsigned long)avrsim::interrupts(avrsim::TIMER2_COMPA_vect_num) );
+	return s_errors ? 1 : 0;
+}
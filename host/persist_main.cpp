@@ -0,0 +1,91 @@
+/**
+ * @file 		  persist_main.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Check that AVRTIMERS_PERSIST restores millis after the right resets.
+ *
+ * Timer1 maintains `millis()`, and the simulated MCU is reset several times.
+ * Like the hardware, a reset adds its cause to the flags still set in MCUSR,
+ * and save_reset_flags() does what the startup code does. After a watchdog,
+ * brown-out or external reset, begin() must restore millis plus the reset
+ * duration, after a power-on reset it must not, even after earlier resets.
+ * Build with `make persist`, exit code is 0 if all checks passed.
+ */
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "AvrSim.h"
+#include "AvrUART.h"
+#include "AvrTimers.h"
+
+#if !AVRTIMERS_PERSIST
+ #error "build with -DAVRTIMERS_PERSIST=1, see 'make persist'"
+#endif
+
+AvrUART0 uart0;
+
+AvrTimer1 timer1;
+
+static int s_errors = 0;
+
+#define CHECK(cond, ...) \
+	do { if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); s_errors++; } } while (0)
+
+static const uint16_t RESET_MS = 5000;
+
+/**
+ * @brief reset with cause `flags`, start Timer1 again and run for 1 s,
+ * check that millis were restored if `restore`, or else kept
+ */
+static void boot(uint8_t flags, bool restore, const char* what)
+{
+	cli();
+	uint32_t ms = millis();
+	avrsim::reset( MCUSR | flags );		// flags stay set until software clears them
+	AvrTimerBase::save_reset_flags();
+	CHECK( MCUSR == 0, "%s: MCUSR=0x%02X not cleared", what, (unsigned)MCUSR );
+
+	timer1.begin( 100 );
+	timer1.start();
+	sei();
+	uint32_t expect = restore ? ms + RESET_MS : ms;
+	printf("%-9s millis %lu -> %lu\n", what, (unsigned long)ms, (unsigned long)millis());
+	CHECK( millis() == expect, "%s: millis %lu, expected %lu",
+		what, (unsigned long)millis(), (unsigned long)expect );
+	CHECK( timer1.get_millis() == expect, "%s: T1 millis %lu, expected %lu",
+		what, (unsigned long)timer1.get_millis(), (unsigned long)expect );
+	avrsim::run_fast_us( 1000000 );
+}
+
+
+int main(int argc, char* argv[])
+{
+	AvrTimerBase::set_reset_ms( RESET_MS );
+	timer1.handle_millis();
+
+	boot( _BV(PORF), false, "power-on" );
+	boot( _BV(WDRF), true, "watchdog" );
+	boot( _BV(BORF), true, "brown-out" );
+	boot( _BV(EXTRF), true, "external" );
+	boot( _BV(PORF), false, "power-on" );
+	boot( _BV(WDRF), true, "watchdog" );
+	boot( 0, false, "no cause" );
+
+	printf("%s\n", s_errors ? "FAILED" : "passed");
+	return s_errors ? 1 : 0;
+}
@@ -0,0 +1,181 @@
+/**
+ * @file 		  ratesweep_main.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Sweep the rate solvers calc_cs() / calc_ocr() of all timers.
+ *
+ * For each timer and clock frequency, every integer rate from 1 Hz up to 
+ * 1 MHz (or the clock frequency) is solved, and the result is checked:
+ *  - invalid:  clock select or OCR out of range for the hardware
+ *  - missed:   solver gave up (cs=0), but the rate is within the range of
+ *              the hardware, between the slowest and fastest possible rate
+ *  - worse:    achieved rate is further from the desired rate than the 
+ *              best prescaler/TOP combination
+ * and the distribution of the relative rate error is printed.
+ * Exit code is 1 if any result is invalid or missed.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "AvrTimers.h"
+
+// expose the protected solvers
+struct Solver0 : AvrTimer0 {
+	using AvrTimer0::calc_cs; using AvrTimer0::calc_ocr; using AvrTimer0::T0_div;
+};
+struct Solver1 : AvrTimer1 {
+	using AvrTimer1::calc_cs; using AvrTimer1::calc_ocr; using AvrTimer1::T1_div;
+};
+struct Solver2 : AvrTimer2 {
+	using AvrTimer2::calc_cs; using AvrTimer2::calc_ocr; using AvrTimer2::T2_div;
+};
+
+/// description of one timer's hardware limits, and its solver
+typedef struct {
+	const char* name;
+	uint8_t max_cs;				///< highest clock select value
+	const uint32_t* div;		///< prescaler per clock select value
+	uint32_t max_period;		///< maximum counts per interrupt, TOP+1
+	void (*solve)(uint32_t fclk, uint32_t rate, uint8_t& cs, uint32_t& period);
+} timer_desc_t;
+
+static void solve0(uint32_t fclk, uint32_t rate, uint8_t& cs, uint32_t& period)
+	{ cs = Solver0::calc_cs(fclk,rate); period = Solver0::calc_ocr(fclk,rate); }
+static void solve1(uint32_t fclk, uint32_t rate, uint8_t& cs, uint32_t& period)
+	{ cs = Solver1::calc_cs(fclk,rate); period = Solver1::calc_ocr(fclk,rate); }
+static void solve2(uint32_t fclk, uint32_t rate, uint8_t& cs, uint32_t& period)
+	{ cs = Solver2::calc_cs(fclk,rate); period = Solver2::calc_ocr(fclk,rate); }
+
+static const timer_desc_t s_timers[3] = {
+	{ "Timer0", 5, Solver0::T0_div, 256, solve0 },
+	{ "Timer1", 5, Solver1::T1_div, 65536, solve1 },
+	{ "Timer2", 7, Solver2::T2_div, 256, solve2 },
+};
+
+/// limits of the error histogram buckets
+static const double s_buckets[] = { 0, 1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1 };
+static const int NBUCKETS = sizeof(s_buckets)/sizeof(s_buckets[0]);
+
+//---------------------------------------------------------------------------
+
+/// @brief true if `rate` is between the slowest and fastest rate of the timer
+static bool in_range(const timer_desc_t& t, uint32_t fclk, uint32_t rate)
+{
+	double slowest = (double)fclk / ((double)t.div[t.max_cs] * t.max_period);
+	double fastest = (double)fclk / t.div[1];
+	return rate >= slowest && rate <= fastest;
+}
+
+
+/// @brief relative error of the best prescaler/TOP combination for `rate`
+static double best_error(const timer_desc_t& t, uint32_t fclk, uint32_t rate)
+{
+	double best = INFINITY;
+	for (uint8_t cs=1; cs<=t.max_cs; cs++) {
+		double p = (double)fclk / ((double)t.div[cs] * rate);
+		double lo = floor(p), hi = ceil(p);
+		if (lo < 1) lo = 1;
+		if (hi < 1) hi = 1;
+		if (lo > t.max_period) lo = t.max_period;
+		if (hi > t.max_period) hi = t.max_period;
+		double e1 = fabs( fclk / (t.div[cs] * lo) - rate ) / rate;
+		double e2 = fabs( fclk / (t.div[cs] * hi) - rate ) / rate;
+		if (e1 < best) best = e1;
+		if (e2 < best) best = e2;
+	}
+	return best;
+}
+
+
+/**
+ * @brief sweep all rates for one timer and clock frequency, print statistics
+ * @return number of invalid or missed results
+ */
+static uint32_t sweep(const timer_desc_t& t, uint32_t fclk, uint32_t max_rate)
+{
+	uint32_t n=0, solved=0, invalid=0, missed=0, worse=0;
+	uint32_t hist[NBUCKETS+1] = {0};
+	double sum_err=0, max_err=0, max_excess=0;
+	uint32_t max_err_rate=0, max_excess_rate=0, first_invalid=0, first_missed=0;
+
+	for (uint32_t rate=1; rate<=max_rate; rate++) {
+		n++;
+		uint8_t cs; 
+		uint32_t period;
+		t.solve( fclk, rate, cs, period );
+		double best = best_error( t, fclk, rate );
+
+		if (cs==0) {
+			if (in_range(t, fclk, rate) && !missed++) 
+				first_missed = rate;
+			continue;
+		}
+		if (cs > t.max_cs || period < 1 || period > t.max_period) {
+			if (!invalid++) first_invalid = rate;
+			continue;
+		}
+		solved++;
+		double err = fabs( (double)fclk / ((double)t.div[cs] * period) - rate ) / rate;
+		sum_err += err;
+		if (err > max_err) { max_err = err; max_err_rate = rate; }
+		if (err > best * (1 + 1e-9) + 1e-12) {
+			worse++;
+			if (err - best > max_excess) { max_excess = err - best; max_excess_rate = rate; }
+		}
+		int b=0;
+		while (b < NBUCKETS && err > s_buckets[b]) b++;
+		hist[b]++;
+	}
+
+	printf("%s  fclk=%8lu Hz  rates 1..%lu: solved %lu, invalid %lu, missed %lu, worse than best %lu\n",
+		t.name, (unsigned long)fclk, (unsigned long)max_rate, (unsigned long)solved, 
+		(unsigned long)invalid, (unsigned long)missed, (unsigned long)worse );
+	if (invalid) printf("  first invalid at %lu Hz\n", (unsigned long)first_invalid);
+	if (missed)  printf("  first missed at %lu Hz\n", (unsigned long)first_missed);
+	if (solved) {
+		printf("  error: mean %.3g, max %.3g at %lu Hz", 
+			sum_err/solved, max_err, (unsigned long)max_err_rate );
+		if (worse) printf(", max excess over best %.3g at %lu Hz", max_excess, (unsigned long)max_excess_rate);
+		printf("\n  histogram:");
+		for (int b=0; b<=NBUCKETS; b++) {
+			if (b==0)				printf("  =0: %lu", (unsigned long)hist[b]);
+			else if (b<NBUCKETS)	printf("  <=%g: %lu", s_buckets[b], (unsigned long)hist[b]);
+			else					printf("  >%g: %lu", s_buckets[NBUCKETS-1], (unsigned long)hist[b]);
+		}
+		printf("\n");
+	}
+	return invalid + missed;
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+	static const uint32_t fclks[] = { 1000000uL, 8000000uL, 16000000uL, 20000000uL };
+	const uint32_t MAX_RATE = 1000000uL;
+	uint32_t failures = 0;
+
+	for (uint8_t i=0; i<3; i++) {
+		for (uint32_t fclk : fclks)
+			failures += sweep( s_timers[i], fclk, fclk < MAX_RATE ? fclk : MAX_RATE );
+	}
+	// Timer2 in async mode, clocked by a watch crystal
+	failures += sweep( s_timers[2], 32768uL, 32768uL );
+
+	printf("%s\n", failures ? "FAILED" : "passed");
+	return failures ? 1 : 0;
+}
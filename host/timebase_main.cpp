@@ -0,0 +1,81 @@
+/**
+ * @file 		  timebase_main.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * @brief  Check AVRTIMERS_TIMEBASE with and without the timebase timer.
+ *
+ * Built with AVRTIMERS_TIMEBASE=2. First only Timer1 exists, and must keep
+ * its own millis. Then Timer2 is created and started, and Timer1 must report
+ * the millis of Timer2. Both are compared with simulated time.
+ * Build with `make timebase`, exit code is 0 if all checks passed.
+ */
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "AvrSim.h"
+#include "AvrUART.h"
+#include "AvrTimers.h"
+
+#if AVRTIMERS_TIMEBASE != 2
+ #error "build with -DAVRTIMERS_TIMEBASE=2, see 'make timebase'"
+#endif
+
+AvrUART0 uart0;
+
+AvrTimer1 timer1;
+
+static int s_errors = 0;
+
+#define CHECK(cond, ...) \
+	do { if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); s_errors++; } } while (0)
+
+/// simulated time since `t0` [ms]
+static uint32_t vms(uint64_t t0) { return (avrsim::cycles() - t0) / (F_CPU / 1000uL); }
+
+
+int main(int argc, char* argv[])
+{
+	avrsim::reset();
+
+	// no timebase timer: Timer1 keeps time
+	timer1.begin( 100 );
+	timer1.start();
+	sei();
+	uint64_t t0 = avrsim::cycles();
+	avrsim::run_fast_us( 2000000 );
+	uint32_t ms = timer1.get_millis();
+	printf("Timer1 alone: %lu ms after %lu ms\n", (unsigned long)ms, (unsigned long)vms(t0));
+	CHECK( ms + 10 > vms(t0) && ms <= vms(t0), "Timer1 without timebase has %lu ms", (unsigned long)ms );
+
+	// Timer2 is the timebase, Timer1 reports its time
+	AvrTimer2* timer2 = new AvrTimer2;
+	timer2->begin( 1000 );
+	timer2->start();
+	t0 = avrsim::cycles();
+	avrsim::run_fast_us( 2000000 );
+	ms = timer2->get_millis();
+	printf("with Timer2: Timer1 %lu ms, Timer2 %lu ms after %lu ms\n",
+		(unsigned long)timer1.get_millis(), (unsigned long)ms, (unsigned long)vms(t0));
+	CHECK( ms + 1 >= vms(t0) && ms <= vms(t0), "Timer2 has %lu ms", (unsigned long)ms );
+	CHECK( timer1.get_millis() == ms, "Timer1 has %lu ms, not those of the timebase",
+		(unsigned long)timer1.get_millis() );
+	CHECK( millis() == ms, "millis() is %lu with timebase", (unsigned long)millis() );
+
+	printf("%s\n", s_errors ? "FAILED" : "passed");
+	return s_errors ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file 		  AvrEvents.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrEvents.cpp $
+ *
+ * @brief  Event flags set by ISRs, with deferred handlers and timeouts.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <util/atomic.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "AvrTimers.h"
+
+#if AVRTIMERS_EVENTS
+
+static_assert( AVRTIMERS_EVENTS <= 8, "AVRTIMERS_EVENTS must be 1..8" );
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+volatile uint8_t AvrEvents::s_flags = 0;
+AvrEvents::handler_rec_t AvrEvents::s_handlers[AVRTIMERS_EVENTS];
+volatile uint16_t AvrEvents::s_left[AVRTIMERS_EVENTS];
+volatile uint8_t AvrEvents::s_expired = 0;
+volatile uint16_t AvrEvents::s_wait = 0;
+uint8_t AvrEvents::s_mask = 0;
+uint8_t AvrEvents::s_n = 0;
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Add the task that counts down timeouts to a timer. Without it,
+ * events work, but timeouts never expire.
+ * @param timer  timer that runs the task
+ * @param scale  count down every `scale` ticks of that timer
+ */
+void AvrEvents::begin(AvrTimerBase& timer, uint16_t scale)
+{
+	timer.add_task( scale, tick );
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Register a handler, to be called from dispatch().
+ * @param mask 	   events that run the handler
+ * @param handler  called with the events that occurred, or with 0 if none
+ * 				   occurred for `timeout` ticks
+ * @param arg 	   passed to the handler
+ * @param timeout  ticks of the task added by begin(), 0 for no timeout
+ * @return handler number for set_timeout(), or NO_HANDLER if there is no room
+ */
+uint8_t AvrEvents::add(uint8_t mask, handler_t handler, void* arg, uint16_t timeout)
+{
+	if (s_n >= AVRTIMERS_EVENTS || !handler) return NO_HANDLER;
+	uint8_t id = s_n;
+	handler_rec_t& h = s_handlers[id];
+	h.handler = handler;
+	h.arg = arg;
+	h.mask = mask;
+	s_mask |= mask;
+	s_n = id + 1;
+	set_timeout( id, timeout );
+	return id;
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief change the timeout of handler `id`, and restart it. 0 for no timeout
+void AvrEvents::set_timeout(uint8_t id, uint16_t timeout)
+{
+	if (id >= s_n) return;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		s_handlers[id].timeout = timeout;
+		s_left[id] = timeout;
+		s_expired &= ~(1 << id);
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief clear and return the events in `mask` that are set
+uint8_t AvrEvents::take(uint8_t mask)
+{
+	uint8_t e;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		e = AVRTIMERS_EVENTS_REG & mask;
+		AVRTIMERS_EVENTS_REG &= ~e;
+	}
+	return e;
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Run the handlers whose events are set, or whose timeout expired. 
+ * Call this from the main loop. Only the events that some handler waits 
+ * for are cleared, others stay set for take() or wait(). 
+ * @return true if any handler ran
+ */
+bool AvrEvents::dispatch(void)
+{
+	uint8_t ev, expired;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		ev = AVRTIMERS_EVENTS_REG & s_mask;
+		AVRTIMERS_EVENTS_REG &= ~ev;
+		expired = s_expired;
+		s_expired = 0;
+	}
+	if (!ev && !expired) return false;
+
+	bool ran = false;
+	handler_rec_t* h = s_handlers;
+	for (uint8_t i=0, bit=1; i<s_n; i++, h++, bit<<=1) {
+		uint8_t e = ev & h->mask;
+		if (e || (expired & bit)) {
+			if (h->timeout) {
+				ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { s_left[i] = h->timeout; }
+			}
+			h->handler( e, h->arg );
+			ran = true;
+		}
+	}
+	return ran;
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Wait until one of the events in `mask` is set, or for `timeout` ticks.
+ * Interrupts must be enabled. 
+ * @param mask 	   events to wait for
+ * @param timeout  ticks of the task added by begin(), 0 to wait forever
+ * @param sleep    sleep in the current sleep mode while waiting, which must 
+ * 				   be one that the timer wakes up from, e.g. idle
+ * @return the events that occurred, cleared, or 0 after a timeout
+ */
+uint8_t AvrEvents::wait(uint8_t mask, uint16_t timeout, bool sleep)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { s_wait = timeout; }
+	for (;;) {
+		cli();
+		uint8_t e = AVRTIMERS_EVENTS_REG & mask;
+		if (e) {
+			AVRTIMERS_EVENTS_REG &= ~e;
+			sei();
+			return e;
+		}
+		if (timeout && s_wait == 0) {
+			sei();
+			return 0;
+		}
+		if (sleep) {
+			sleep_enable();
+			sei();				// the instruction after sei is executed before any interrupt
+			sleep_cpu();
+			sleep_disable();
+		} else {
+			sei();
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief Count down the timeouts. Called from the timer task.
+void AvrEvents::tick(void* arg)
+{
+	uint16_t w = s_wait;
+	if (w) s_wait = w - 1;
+
+	volatile uint16_t* p = s_left;
+	for (uint8_t i=0, bit=1; i<s_n; i++, p++, bit<<=1) {
+		uint16_t c = *p;
+		if (c && --c == 0) {
+			s_expired |= bit;
+			c = s_handlers[i].timeout;		// expire again after another timeout
+		}
+		*p = c;
+	}
+}
+
+/** @} */
+
+#endif // AVRTIMERS_EVENTS
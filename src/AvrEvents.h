@@ -0,0 +1,116 @@
+/**
+ * @file 		  AvrEvents.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrEvents.h $
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVREVENTS_H_
+#define AVREVENTS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+class AvrTimerBase;
+
+// register that holds the event flags, GPIOR0 if the MCU has one
+#ifndef AVRTIMERS_EVENTS_REG
+ #ifdef GPIOR0
+  #define AVRTIMERS_EVENTS_REG GPIOR0
+  #define AVRTIMERS_EVENTS_SBI 1		// setting a single flag is one `sbi` instruction
+ #else
+  #define AVRTIMERS_EVENTS_REG AvrEvents::s_flags
+ #endif
+#endif
+#ifndef AVRTIMERS_EVENTS_SBI
+ #define AVRTIMERS_EVENTS_SBI 0
+#endif
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+/**
+ * @brief Event flags, set by any ISR, and handlers that run deferred, 
+ * from the main loop, when one of their events is set or a timeout expires.
+ * 
+ * Enabled by defining `AVRTIMERS_EVENTS` as the maximum number of handlers,
+ * 1..8. The 8 event flags are kept in `GPIOR0` where available, so set() 
+ * with a constant single flag compiles to one `sbi` instruction, which is
+ * atomic. begin() adds a task to a timer, which counts down the timeouts 
+ * of handlers and of wait(), in ticks of that task.
+ *
+ * ```C++
+ * ISR(USART_RX_vect) { ... AvrEvents::set(EV_RX); }
+ * AvrEvents::begin( timer0, 10 );				// timeouts in 10 ms steps
+ * AvrEvents::add( EV_RX, on_rx, NULL, 100 );	// on_rx(0,NULL) if idle for 1 s
+ * while (1) {
+ *     AvrEvents::dispatch();
+ *     ...
+ * }
+ * ```
+ */
+class AvrEvents {
+public:
+	/// handler, called with the events that occurred, or 0 after a timeout
+	typedef void (*handler_t)(uint8_t events, void* arg);
+	/// returned by add() if there is no room
+	static const uint8_t NO_HANDLER = 0xFF;
+
+	static void begin(AvrTimerBase& timer, uint16_t scale=1);
+	static uint8_t add(uint8_t mask, handler_t handler, void* arg=NULL, uint16_t timeout=0);
+	static void set_timeout(uint8_t id, uint16_t timeout);
+
+	/// @brief set event flags, from an ISR or the main loop
+	static inline void set(uint8_t events) __attribute__((always_inline)) {
+		if (AVRTIMERS_EVENTS_SBI && __builtin_constant_p(events) && !(events & (events-1))) {
+			AVRTIMERS_EVENTS_REG |= events;
+		} else {
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { AVRTIMERS_EVENTS_REG |= events; }
+		}
+	}
+	/// @brief event flags that are currently set
+	static uint8_t get(void) { return AVRTIMERS_EVENTS_REG; }
+	static uint8_t take(uint8_t mask);
+	static bool dispatch(void);
+	static uint8_t wait(uint8_t mask, uint16_t timeout=0, bool sleep=true);
+
+	static void tick(void* arg=NULL);
+	/// @brief timer task that sets the events in `arg`, e.g. `add_task(100, AvrEvents::post, (void*)EV_SLOW)`
+	static void post(void* arg) { set( (uint8_t)(uintptr_t)arg ); }
+
+	/// event flags, if there is no GPIOR0
+	static volatile uint8_t s_flags;
+protected:
+	/// parameters of one handler
+	typedef struct _handler_rec_t {
+		handler_t handler;
+		void*    arg;
+		uint16_t timeout;			///< timeout [ticks], 0 for none
+		uint8_t  mask;				///< events that run the handler
+	} handler_rec_t;
+	static handler_rec_t s_handlers[];
+	static volatile uint16_t s_left[];	///< ticks left until timeout, per handler
+	static volatile uint8_t s_expired;	///< handlers whose timeout expired, one bit each
+	static volatile uint16_t s_wait;	///< ticks left until wait() times out
+	static uint8_t s_mask;				///< events that any handler waits for
+	static uint8_t s_n;					///< # of handlers added
+};
+
+/** @} */
+
+#endif // AVREVENTS_H_
@@ -0,0 +1,100 @@
+/**
+ * @file 		  AvrLoopMonitor.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrLoopMonitor.cpp $
+ *
+ * @brief  Main loop period statistics and deadline monitor.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "AvrTimers.h"
+#include "AvrLoopMonitor.h"
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+//---------------------------------------------------------------------------
+
+AvrLoopMonitor::AvrLoopMonitor(AvrTimerBase& timer) : m_timer(timer), 
+	m_last(0), m_deadline_us(0), m_started(false)
+{
+	reset();
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Start monitoring, typically after the timer has been started.
+ * @param deadline_us  count loop periods longer than this [us], 0 for none
+ */
+void AvrLoopMonitor::begin(uint32_t deadline_us)
+{
+	m_deadline_us = deadline_us;
+	reset();
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief clear the statistics, and start a new measurement with the next loop()
+void AvrLoopMonitor::reset(void)
+{
+	memset( &m_stats, 0, sizeof(m_stats) );
+	m_stats.min_us = UINT32_MAX;
+	m_started = false;
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief call once per iteration of the main loop
+void AvrLoopMonitor::loop(void)
+{
+	uint32_t now = m_timer.get_micros();
+	if (m_started) {
+		uint32_t us = now - m_last;
+		m_stats.iterations++;
+		m_stats.last_us = us;
+		// halve the sum and its count, rather than dividing a 64-bit sum later
+		while (m_stats.total_us + us < us) {
+			if (m_stats.avg_n & 1) {	// drop one average period first, to keep the average
+				m_stats.total_us -= m_stats.total_us / m_stats.avg_n;
+				m_stats.avg_n--;
+			}
+			m_stats.total_us >>= 1;
+			m_stats.avg_n >>= 1;
+		}
+		m_stats.total_us += us;
+		m_stats.avg_n++;
+		if (us < m_stats.min_us) m_stats.min_us = us;
+		if (us > m_stats.max_us) m_stats.max_us = us;
+		if (m_deadline_us && us > m_deadline_us) m_stats.misses++;
+	}
+	m_last = now;
+	m_started = true;
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief average loop period [us], 0 if nothing measured yet
+uint32_t AvrLoopMonitor::get_avg_us(void)
+{
+	if (!m_stats.avg_n) return 0;
+	return m_stats.total_us / m_stats.avg_n;
+}
+
+/** @} */
@@ -0,0 +1,77 @@
+/**
+ * @file 		  AvrLoopMonitor.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrLoopMonitor.h $
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRLOOPMONITOR_H_
+#define AVRLOOPMONITOR_H_
+
+#include <stdint.h>
+#include "AvrTimers.h"
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+/**
+ * @brief Measure the period of the main loop, and count deadline misses.
+ * 
+ * Call loop() once per iteration of the main loop. It takes a timestamp 
+ * with `get_micros()` of the timer, and updates minimum, maximum and 
+ * average period, and counts periods longer than the deadline set with 
+ * begin(). Call skip() after something that is expected to take long 
+ * (e.g. sleeping, or writing EEPROM), so that iteration is not counted.
+ * 
+ * Periods are limited by the wrap-around of `get_micros()`, i.e. 71 minutes.
+ */
+class AvrLoopMonitor {
+public:
+	/// statistics, see get_stats()
+	typedef struct _loop_stats_t {
+		uint32_t iterations;	///< # of periods measured
+		uint32_t misses;		///< # of periods longer than the deadline
+		uint32_t last_us;		///< last period [us]
+		uint32_t min_us;		///< shortest period [us]
+		uint32_t max_us;		///< longest period [us]
+		uint32_t total_us;		///< sum of the last `avg_n` periods [us]
+		uint32_t avg_n;			///< # of periods in `total_us`, both are halved before the sum overflows
+	} loop_stats_t;
+
+	AvrLoopMonitor(AvrTimerBase& timer);
+
+	void begin(uint32_t deadline_us=0);
+	void loop(void);
+	/// @brief don't count the time since the last call to loop()
+	void skip(void) { m_started = false; }
+	void reset(void);
+
+	/// @brief deadline for one loop period [us], 0 if none
+	uint32_t get_deadline() { return m_deadline_us; }
+	void set_deadline(uint32_t deadline_us) { m_deadline_us = deadline_us; }
+	uint32_t get_avg_us(void);
+	const loop_stats_t& get_stats() { return m_stats; }
+protected:
+	AvrTimerBase& m_timer;
+	uint32_t    m_last;				///< timestamp of last call to loop() [us]
+	uint32_t    m_deadline_us;
+	bool        m_started;			///< m_last is valid
+	loop_stats_t m_stats;
+};
+
+/** @} */
+
+#endif // AVRLOOPMONITOR_H_
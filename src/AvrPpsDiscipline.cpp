@@ -0,0 +1,218 @@
+/**
+ * @file 		  AvrPpsDiscipline.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrPpsDiscipline.cpp $
+ *
+ * @brief  Discipline the millis/micros timebase to an external PPS signal.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <util/atomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "AvrTimers.h"
+#include "AvrPpsDiscipline.h"
+#if DEBUG_AVRTIMERS
+ #include "debugstream.h"
+#endif
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+//---------------------------------------------------------------------------
+
+AvrPpsDiscipline::AvrPpsDiscipline(AvrTimerBase& timer) : m_timer(timer), 
+	m_edge(false), m_timeout_ms(1500), m_tau(8), m_good(0), m_state(Unlocked)
+{
+	memset( &m_stats, 0, sizeof(m_stats) );
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Start disciplining the timer, typically after the timer has been started.
+ * @param tau 		  time constant for phase corrections [s]
+ * @param timeout_ms  enter holdover if no PPS edge for this long [ms]
+ */
+void AvrPpsDiscipline::begin(uint8_t tau, uint16_t timeout_ms)
+{
+	m_tau = tau ? tau : 1;
+	m_timeout_ms = timeout_ms;
+	m_state = Unlocked;
+	m_good = 0;
+	m_edge = false;
+	m_timer.set_trim(0);
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief Record a PPS edge, call this from the PPS interrupt
+void AvrPpsDiscipline::pps_edge(void)
+{
+	pps_edge( m_timer.get_micros() );
+}
+
+
+/** 
+ * @brief Record a PPS edge with a known timestamp, e.g. from input capture
+ * @param us  timestamp of the edge, on the timebase of the disciplined timer [us]
+ */
+void AvrPpsDiscipline::pps_edge(uint32_t us)
+{
+	m_edge_us = us;
+	m_edge = true;
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Set the trim of the disciplined timer
+ * @param ppm  correction [ppm], positive makes the timer run faster
+ */
+void AvrPpsDiscipline::steer(float ppm)
+{
+	// 1 ppm of the tick period, in units of 2^-32 ms
+	float unit = m_timer.get_tick_ms() * 4294.967296f;
+	m_timer.set_trim( (int32_t)(ppm * unit) );
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Step the timer so that a second boundary falls on the PPS edge.
+ * The position of the edge within the second is derived from millis, because
+ * micros wrap around after 2^32 us, which is not a whole number of seconds.
+ * @param t  timestamp of the edge [us]
+ */
+void AvrPpsDiscipline::align(uint32_t t)
+{
+	uint32_t ms, us;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		ms = m_timer.get_millis();
+		us = m_timer.get_micros();
+	}
+	// micros and millis*1000 wrap around together, so this is the time since the last ms
+	uint32_t sub_us = us - ms * 1000uL;
+	// position of now within the second, minus the time since the edge
+	int32_t phase = (int32_t)((ms % 1000uL) * 1000uL + sub_us) - (int32_t)(us - t);
+	phase %= 1000000L;
+	if (phase >= 500000L) phase -= 1000000L;
+	else if (phase < -500000L) phase += 1000000L;
+
+	m_timer.adjust_time( -phase );
+	m_expect_us = t - phase + 1000000uL;
+	m_last_ms = m_timer.get_millis();
+	m_stats.edges++;
+	m_stats.steps++;
+	m_stats.holdover_s = 0;
+	m_good = 0;
+	m_state = Tracking;
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Process PPS edges and maintain holdover state, call this from the main loop.
+ * @return true if a new PPS edge has been processed
+ */
+bool AvrPpsDiscipline::update(void)
+{
+	uint32_t t;
+	bool edge;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		t = m_edge_us;
+		edge = m_edge;
+		m_edge = false;
+	}
+
+	if (!edge) {
+		if (m_state != Unlocked) {
+			uint32_t since = m_timer.get_millis() - m_last_ms;
+			if (since > m_timeout_ms) {
+				if (m_state != Holdover) {
+					m_state = Holdover;
+					m_stats.holdovers++;
+					steer( -m_stats.freq_ppm );		// drop phase correction
+				}
+				m_stats.holdover_s = since / 1000uL;
+				if (m_stats.holdover_s > m_stats.max_holdover_s)
+					m_stats.max_holdover_s = m_stats.holdover_s;
+			}
+		}
+		return false;
+	}
+
+	if (m_state == Unlocked || 
+		(m_state == Holdover && m_timer.get_millis() - m_last_ms > REACQUIRE_MS)) {
+		// first edge, or t - m_expect_us may have overflowed: align again
+		align( t );
+		return true;
+	}
+
+	// which second is this, allowing for missed edges? n<1 means too early
+	int16_t n = 1;
+	int32_t phase = t - m_expect_us;
+	while (phase > 500000L) {
+		phase -= 1000000L;
+		n++;
+	}
+	while (phase < -500000L) {
+		phase += 1000000L;
+		n--;
+	}
+	if (n < 1 || labs(phase) > REJECT_US * n) {
+		m_stats.rejected++;
+		return false;
+	}
+	m_expect_us += n * 1000000uL;
+	m_last_ms = m_timer.get_millis();
+	m_stats.edges++;
+	m_stats.phase_us = phase;
+	m_stats.holdover_s = 0;
+
+	if (labs(phase) > STEP_US) {
+		m_timer.adjust_time( -phase );
+		m_stats.steps++;
+		m_good = 0;
+		m_state = Tracking;
+	} else {
+		// phase drift over n seconds is the residual frequency error [ppm]
+		m_stats.freq_ppm += (float)phase / (n * m_tau);
+		if (labs(phase) < LOCK_US) {
+			if (m_good < LOCK_COUNT) m_good++;
+		} else {
+			m_good = 0;
+		}
+		m_state = (m_good >= LOCK_COUNT) ? Locked : Tracking;
+	}
+
+	// cancel the frequency error, and slew the phase error out over tau seconds
+	steer( -m_stats.freq_ppm - (float)phase / m_tau );
+
+#if DEBUG_AVRTIMERS
+	DEBUG_PRINTF("PPS: phase %ld us, freq %ld ppb\r\n", 
+		(long)phase, (long)(m_stats.freq_ppm * 1000.0f) );
+#endif
+	return true;
+}
+
+/** @} */
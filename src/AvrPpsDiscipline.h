@@ -0,0 +1,94 @@
+/**
+ * @file 		  AvrPpsDiscipline.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrPpsDiscipline.h $
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRPPSDISCIPLINE_H_
+#define AVRPPSDISCIPLINE_H_
+
+#include <stdint.h>
+#include "AvrTimers.h"
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+/**
+ * @brief Discipline the timebase of a timer to an external pulse-per-second signal.
+ * 
+ * Call pps_edge() from the interrupt triggered by the PPS signal (e.g. INT0 
+ * or pin change), and update() from the main loop. The discipline measures
+ * the phase and frequency error of the timer against the PPS edges, and
+ * steers the tick period of the timer via AvrTimerBase::set_trim(), so that
+ * `get_millis()` and `get_micros()` track true time. If the PPS signal 
+ * disappears, the last frequency estimate is kept (holdover).
+ */
+class AvrPpsDiscipline {
+public:
+	enum State { Unlocked=0, Tracking, Locked, Holdover };
+
+	/// statistics, see get_stats()
+	typedef struct _pps_stats_t {
+		uint32_t edges;			///< # of PPS edges accepted
+		uint16_t rejected;		///< # of PPS edges rejected as glitches
+		uint16_t steps;			///< # of times the phase was stepped rather than slewed
+		int32_t  phase_us;		///< phase error at last edge [us]
+		float    freq_ppm;		///< estimated frequency error of the timer [ppm]
+		uint32_t holdover_s;	///< seconds since last PPS edge, while in holdover
+		uint32_t max_holdover_s;///< longest holdover so far [s]
+		uint16_t holdovers;		///< # of times PPS was lost
+	} pps_stats_t;
+
+	/// phase errors larger than this are stepped, smaller ones are slewed [us]
+	static const int32_t STEP_US = 500;
+	/// edges further than this from the expected time are rejected [us]
+	static const int32_t REJECT_US = 2000;
+	/// |phase error| below this for LOCK_COUNT edges means Locked [us]
+	static const int32_t LOCK_US = 20;
+	static const uint8_t LOCK_COUNT = 8;
+	/// after a holdover this long, align to the next edge like to the first one [ms],
+	/// well before the expected timestamp is 2^31 us (35.8 min) old
+	static const uint32_t REACQUIRE_MS = 1800000uL;
+
+	AvrPpsDiscipline(AvrTimerBase& timer);
+
+	void begin(uint8_t tau=8, uint16_t timeout_ms=1500);
+	void pps_edge(void);
+	void pps_edge(uint32_t us);
+	bool update(void);
+
+	State get_state() { return m_state; }
+	const pps_stats_t& get_stats() { return m_stats; }
+protected:
+	AvrTimerBase& m_timer;
+	volatile uint32_t m_edge_us;	///< timestamp of last PPS edge
+	volatile bool m_edge;			///< new edge waiting for update()
+	uint32_t    m_expect_us;		///< timestamp of the expected next second boundary
+	uint32_t    m_last_ms;			///< millis at last accepted edge
+	uint16_t    m_timeout_ms;
+	uint8_t     m_tau;				///< phase time constant [s]
+	uint8_t     m_good;				///< consecutive edges within LOCK_US
+	State       m_state;
+	pps_stats_t m_stats;
+
+	void steer(float ppm);
+	void align(uint32_t t);
+};
+
+/** @} */
+
+#endif // AVRPPSDISCIPLINE_H_
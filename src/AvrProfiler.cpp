@@ -0,0 +1,232 @@
+/**
+ * @file 		  AvrProfiler.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrProfiler.cpp $
+ *
+ * @brief  Statistical profiler, samples the program counter in a timer interrupt.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <util/atomic.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "AvrTimers.h"
+
+#if AVRTIMERS_PROFILE
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+uint16_t AvrProfiler::s_hist[AVRTIMERS_PROFILE];
+uint16_t AvrProfiler::s_base = 0;
+uint8_t  AvrProfiler::s_shift = 15;
+uint16_t AvrProfiler::s_other = 0;
+uint32_t AvrProfiler::s_total = 0;
+volatile bool AvrProfiler::s_enabled = false;
+
+/// interrupted program counter [words], written by the naked ISR
+extern "C" volatile uint16_t avrprofiler_pc;
+volatile uint16_t avrprofiler_pc;
+
+/// end of code, from the linker script
+extern "C" char _etext[];
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_PROFILE_TIMER==0
+ #define PROFILE_vect	AVRTIMER0_vect
+ #define PROFILE_ISR()	AvrTimer0::theInstance->call_tasks()
+ #define PROFILE_NEST_BEGIN()	AVRTIMERS_NEST_BEGIN( AVRTIMER0_NESTING, AvrTimer0::theInstance, TIMSK0, AVRTIMER0_IE )
+ #define PROFILE_NEST_END()	AVRTIMERS_NEST_END( AVRTIMER0_NESTING, AvrTimer0::theInstance, TIMSK0, AVRTIMER0_IE )
+#elif AVRTIMERS_PROFILE_TIMER==1
+ #define PROFILE_vect	TIMER1_OVF_vect
+ #define PROFILE_ISR()	AvrTimer1::theInstance->call_tasks()
+ #define PROFILE_NEST_BEGIN()	AVRTIMERS_NEST_BEGIN( AVRTIMER1_NESTING, AvrTimer1::theInstance, TIMSK1, TOIE1 )
+ #define PROFILE_NEST_END()	AVRTIMERS_NEST_END( AVRTIMER1_NESTING, AvrTimer1::theInstance, TIMSK1, TOIE1 )
+#else
+ #define PROFILE_vect	TIMER2_COMPA_vect
+ #define PROFILE_ISR()	AvrTimer2::theInstance->isr()
+ #define PROFILE_NEST_BEGIN()	AVRTIMERS_NEST_BEGIN( AVRTIMER2_NESTING, AvrTimer2::theInstance, TIMSK2, OCIE2A )
+ #define PROFILE_NEST_END()	AVRTIMERS_NEST_END( AVRTIMER2_NESTING, AvrTimer2::theInstance, TIMSK2, OCIE2A )
+#endif
+
+// offset of the return address from SP, after pushing 3 registers
+#if defined(__AVR_3_BYTE_PC__)
+ #define PC_HI	"5"
+ #define PC_LO	"6"
+#else
+ #define PC_HI	"4"
+ #define PC_LO	"5"
+#endif
+
+#ifdef __AVR_HAVE_JMP_CALL__
+ #define JMP	"jmp "
+#else
+ #define JMP	"rjmp "
+#endif
+
+#ifdef __AVR__
+ #define PROFILE_SIGNAL	__attribute__((signal, used, externally_visible))
+#else
+ #define PROFILE_SIGNAL
+#endif
+
+extern "C" void __vector_profile(void) PROFILE_SIGNAL;
+
+/**
+ * Naked ISR: save the return address, without changing SREG or any register, 
+ * then continue in the regular ISR __vector_profile().
+ */
+ISR(PROFILE_vect, ISR_NAKED)
+{
+#ifdef __AVR__
+	__asm__ __volatile__ (
+		"push r0"						"\n\t"
+		"push r30"						"\n\t"
+		"push r31"						"\n\t"
+		"in   r30, __SP_L__"			"\n\t"
+		"in   r31, __SP_H__"			"\n\t"
+		"ldd  r0, Z+" PC_HI				"\n\t"
+		"sts  avrprofiler_pc+1, r0"		"\n\t"
+		"ldd  r0, Z+" PC_LO				"\n\t"
+		"sts  avrprofiler_pc, r0"		"\n\t"
+		"pop  r31"						"\n\t"
+		"pop  r30"						"\n\t"
+		"pop  r0"						"\n\t"
+		JMP "__vector_profile"			"\n\t"
+		::: "memory" );
+#else
+	__vector_profile();		// host build: no program counter to sample
+#endif
+}
+
+
+/// @brief count the sample, then do what the library ISR of the timer does
+void __vector_profile(void)
+{
+	AvrProfiler::sample( avrprofiler_pc );
+	AVRTIMERS_ISR_ENTER();
+#if AVRTIMERS_PROFILE_TIMER==1 && AVRTIMERS_STOPWATCH
+	AvrTimer1::theInstance->count_cycles();
+#endif
+	PROFILE_NEST_BEGIN();
+	PROFILE_ISR();
+	PROFILE_NEST_END();
+	AVRTIMERS_ISR_EXIT();
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Count one sample. Called from the ISR with interrupts disabled.
+ * @param pc  program counter [words]
+ */
+void AvrProfiler::sample(uint16_t pc)
+{
+	if (!s_enabled) return;
+	s_total++;
+	uint16_t i = (uint16_t)(pc - s_base) >> s_shift;
+	if (pc >= s_base && i < AVRTIMERS_PROFILE) {
+		if (s_hist[i] != UINT16_MAX) s_hist[i]++;
+	} else {
+		if (s_other != UINT16_MAX) s_other++;
+	}
+}
+
+
+/**
+ * @brief Divide an address range into AVRTIMERS_PROFILE buckets, clear the 
+ * histogram, and start sampling.
+ * @param first  first code address [bytes]
+ * @param last   last code address [bytes], 0 for end of code
+ */
+void AvrProfiler::begin(uint16_t first, uint16_t last)
+{
+	if (last == 0) last = (uint16_t)(uintptr_t)_etext;
+	uint16_t words = ((last - first) >> 1) + 1;
+	uint8_t shift = 0;
+	while (shift < 15 && ((words-1) >> shift) >= AVRTIMERS_PROFILE) shift++;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		s_base = first >> 1;
+		s_shift = shift;
+	}
+	clear();
+	enable();
+}
+
+
+/// @brief clear the histogram
+void AvrProfiler::clear(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (uint16_t i=0; i<AVRTIMERS_PROFILE; i++) s_hist[i] = 0;
+		s_other = 0;
+		s_total = 0;
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief send one byte via USART0, polled. The UART must be initialized.
+static void uart_put(uint8_t c)
+{
+#ifdef UDR0
+	while (!(UCSR0A & _BV(UDRE0))) {}
+	UDR0 = c;
+#endif
+}
+
+
+static void put16(AvrProfiler::putbyte_t put, uint16_t x)
+{
+	put( x & 0xFF );
+	put( x >> 8 );
+}
+
+
+/**
+ * @brief Send the histogram in binary, see class description for the format.
+ * Sampling is paused while sending.
+ * @param put  function to send one byte, default is USART0 polled
+ */
+void AvrProfiler::dump(putbyte_t put)
+{
+	if (!put) put = uart_put;
+	bool was = s_enabled;
+	s_enabled = false;
+
+	put('A'); put('P'); put(1);
+	put16( put, s_base << 1 );
+	put( s_shift + 1 );
+	put16( put, AVRTIMERS_PROFILE );
+	put16( put, s_other );
+	put16( put, s_total & 0xFFFF );
+	put16( put, s_total >> 16 );
+	for (uint16_t i=0; i<AVRTIMERS_PROFILE; i++)
+		put16( put, s_hist[i] );
+
+	s_enabled = was;
+}
+
+/** @} */
+
+#endif // AVRTIMERS_PROFILE
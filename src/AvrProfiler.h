@@ -0,0 +1,76 @@
+/**
+ * @file 		  AvrProfiler.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrProfiler.h $
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRPROFILER_H_
+#define AVRPROFILER_H_
+
+#include <stdint.h>
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+/**
+ * @brief Statistical profiler: sample the program counter in a timer interrupt.
+ * 
+ * Enabled by defining `AVRTIMERS_PROFILE` as the number of histogram buckets,
+ * e.g. 128 (2 bytes RAM each), and `AVRTIMERS_PROFILE_TIMER` as the timer 
+ * (0, 1 or 2, default 2) whose interrupt takes the samples. That timer's 
+ * library ISR is replaced by a naked ISR, which reads the address of the 
+ * interrupted instruction from the stack, counts it in the histogram, and 
+ * then does everything the normal ISR does, so the timer's tasks and millis
+ * keep working. The sampling rate is the interrupt rate of that timer, as
+ * set by its begin(). Pick a rate that is not a multiple of any periodic 
+ * activity in the code being profiled.
+ *
+ * begin() divides an address range (default: all code) into equal buckets.
+ * Samples outside that range are counted separately. dump() sends the 
+ * histogram in binary, and `tools/pcprof` maps the buckets to the symbols 
+ * in the ELF file and prints a flat profile.
+ *
+ * dump() format, all values little endian:
+ *  - 'A' 'P' version=1
+ *  - first address [bytes] (uint16_t), log2 of bucket size [bytes] (uint8_t),
+ *    number of buckets (uint16_t), samples outside the range (uint16_t),
+ *    total samples (uint32_t)
+ *  - count per bucket (uint16_t each). Counts saturate at 65535.
+ */
+class AvrProfiler {
+public:
+	typedef void (*putbyte_t)(uint8_t);
+
+	static void begin(uint16_t first=0, uint16_t last=0);
+	static void clear(void);
+	/// @brief start or stop taking samples
+	static void enable(bool on=true) { s_enabled = on; }
+	static void dump(putbyte_t put=NULL);
+	static void sample(uint16_t pc);
+
+protected:
+	static uint16_t s_hist[];
+	static uint16_t s_base;		///< first word address
+	static uint8_t  s_shift;	///< log2 of bucket size [words]
+	static uint16_t s_other;	///< samples outside the range
+	static uint32_t s_total;
+	static volatile bool s_enabled;
+};
+
+/** @} */
+
+#endif // AVRPROFILER_H_
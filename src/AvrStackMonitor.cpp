@@ -0,0 +1,149 @@
+/**
+ * @file 		  AvrStackMonitor.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrStackMonitor.cpp $
+ *
+ * @brief  Stack high-water mark and ISR nesting monitor.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <util/atomic.h>
+#include <avr/io.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "AvrTimers.h"
+
+#if AVRTIMERS_STACK_MONITOR
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+#ifdef __AVR__
+/// end of static variables, and top of the stack, from the linker script
+extern uint8_t _end;
+extern uint8_t __stack;
+ #define STACK_BOTTOM		(&_end)
+ #define STACK_TOP			(&__stack)
+ #define STACK_BOTTOM_ADDR	((uint16_t)(uintptr_t)&_end)
+#else
+/// no AVR memory map on other targets, e.g. the host simulation: scan an
+/// array of the size of the AVR's RAM instead, painted by begin()
+static uint8_t s_ram[RAMEND+1 - RAMSTART];
+ #define STACK_BOTTOM		(s_ram)
+ #define STACK_TOP			(s_ram + sizeof(s_ram))
+ #define STACK_BOTTOM_ADDR	RAMSTART
+#endif
+
+uint8_t* AvrStackMonitor::s_mark = STACK_TOP;
+uint8_t* AvrStackMonitor::s_pos = STACK_BOTTOM;
+volatile uint16_t AvrStackMonitor::s_min_sp = UINT16_MAX;
+volatile uint8_t AvrStackMonitor::s_depth = 0;
+uint8_t AvrStackMonitor::s_max_depth = 0;
+
+//---------------------------------------------------------------------------
+
+#ifdef __AVR__
+
+extern "C" void avrstackmonitor_paint(void) __attribute__((naked, used, section(".init1")));
+
+/**
+ * Fill RAM from _end to the top of the stack with CANARY. Runs before the 
+ * stack pointer and r1 are set up, so it must not use the stack or r1.
+ */
+void avrstackmonitor_paint(void)
+{
+	__asm__ __volatile__ (
+		"ldi  r30, lo8(_end)"		"\n\t"
+		"ldi  r31, hi8(_end)"		"\n\t"
+		"ldi  r24, %0"				"\n\t"
+		"ldi  r25, hi8(__stack)"	"\n\t"
+		"rjmp 2f"					"\n"
+	"1:	st   Z+, r24"				"\n"
+	"2:	cpi  r30, lo8(__stack)"		"\n\t"
+		"cpc  r31, r25"				"\n\t"
+		"brlo 1b"					"\n\t"
+		"breq 1b"					"\n\t"
+		:: "M" (AvrStackMonitor::CANARY) );
+}
+
+#endif // __AVR__
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Start scanning for the stack high-water mark.
+ * @param timer  timer that runs the scan task
+ * @param scale  scan every `scale` ticks of that timer
+ */
+void AvrStackMonitor::begin(AvrTimerBase& timer, uint16_t scale)
+{
+#ifndef __AVR__
+	memset( s_ram, CANARY, sizeof(s_ram) );
+#endif
+	timer.add_task( scale, scan );
+}
+
+
+/// @brief Check the next SCAN_BYTES bytes of the painted area. Called from the timer task.
+void AvrStackMonitor::scan(void* arg)
+{
+	uint8_t* p = s_pos;
+	uint8_t* mark = s_mark;
+	for (uint8_t n=0; n<SCAN_BYTES; n++, p++) {
+		if (p >= mark) {
+			p = STACK_BOTTOM;				// nothing new below the mark, start over
+			break;
+		}
+		if (*p != CANARY) {
+			s_mark = p;				// stack has grown to here
+			p = STACK_BOTTOM;
+			break;
+		}
+	}
+	s_pos = p;
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief stack bytes never used so far, as far as the scan has seen
+uint16_t AvrStackMonitor::get_free(void)
+{
+	uint8_t* mark;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		mark = s_mark;
+	}
+	return mark - STACK_BOTTOM;
+}
+
+
+/// @brief free stack bytes at the deepest entry into a library timer ISR, UINT16_MAX if none yet
+uint16_t AvrStackMonitor::get_isr_free(void)
+{
+	uint16_t sp;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		sp = s_min_sp;
+	}
+	if (sp == UINT16_MAX) return sp;
+	return sp - STACK_BOTTOM_ADDR;
+}
+
+/** @} */
+
+#endif // AVRTIMERS_STACK_MONITOR
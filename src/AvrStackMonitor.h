@@ -0,0 +1,83 @@
+/**
+ * @file 		  AvrStackMonitor.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrStackMonitor.h $
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRSTACKMONITOR_H_
+#define AVRSTACKMONITOR_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+
+class AvrTimerBase;
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+/**
+ * @brief Stack high-water mark and ISR nesting monitor.
+ * 
+ * Enabled by defining `AVRTIMERS_STACK_MONITOR` !=0. At startup, before 
+ * main(), the RAM between the end of static variables and the top of the 
+ * stack is painted with a fixed pattern. begin() adds a task to a timer 
+ * that scans a few bytes of that area per tick, to find the lowest address
+ * the stack has ever reached, without disturbing the timing of the 
+ * application.
+ *
+ * In addition, the library timer ISRs record the stack pointer on entry, 
+ * and how deeply they are nested. With the default nesting policy 
+ * AVRTIMERS_NEST_ALL, the library ISRs enable interrupts again, so they can 
+ * nest inside each other, see AVRTIMERn_NESTING.
+ *
+ * If the application uses malloc(), the heap grows into the same area and 
+ * is counted as used stack.
+ */
+class AvrStackMonitor {
+public:
+	/// value painted into the free RAM
+	static const uint8_t CANARY = 0xC5;
+	/// bytes checked per call to scan()
+	static const uint8_t SCAN_BYTES = 16;
+
+	static void begin(AvrTimerBase& timer, uint16_t scale=1);
+	static void scan(void* arg=NULL);
+	static uint16_t get_free(void);
+	static uint16_t get_isr_free(void);
+	/// @brief deepest nesting of library timer ISRs seen so far
+	static uint8_t get_max_nesting(void) { return s_max_depth; }
+
+	/// @brief called on entry to a library timer ISR, with interrupts disabled
+	static void isr_enter(void) {
+		uint16_t sp = SP;
+		if (sp < s_min_sp) s_min_sp = sp;
+		if (++s_depth > s_max_depth) s_max_depth = s_depth;
+	}
+	/// @brief called on exit from a library timer ISR
+	static void isr_exit(void) { s_depth--; }
+
+protected:
+	static uint8_t* s_mark;			///< lowest address known to be used by the stack
+	static uint8_t* s_pos;			///< next address to scan
+	static volatile uint16_t s_min_sp;	///< lowest SP on ISR entry
+	static volatile uint8_t s_depth;	///< current ISR nesting depth
+	static uint8_t s_max_depth;
+};
+
+/** @} */
+
+#endif // AVRSTACKMONITOR_H_
@@ -0,0 +1,145 @@
+/**
+ * @file 		  AvrStopwatch.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrStopwatch.cpp $
+ *
+ * @brief  Cycle counting statistics for regions of code, based on Timer1.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <util/atomic.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "AvrTimers.h"
+#include "AvrStopwatch.h"
+#if DEBUG_AVRTIMERS
+ #include "debugstream.h"
+#endif
+
+#if AVRTIMERS_STOPWATCH
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+AvrStopwatch::Region* AvrStopwatch::s_first = NULL;
+uint16_t AvrStopwatch::s_overhead = 0;
+
+//---------------------------------------------------------------------------
+
+/// @brief constructor, adds the region to the list of all regions
+AvrStopwatch::Region::Region(const char* name_) : name(name_), next(s_first)
+{
+	s_first = this;
+	reset();
+}
+
+
+/// @brief clear the statistics
+void AvrStopwatch::Region::reset(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		count = 0;
+		min = UINT32_MAX;
+		max = 0;
+		total = 0;
+		avg_n = 0;
+	}
+}
+
+
+/// @brief add one measurement
+void AvrStopwatch::Region::add(uint32_t cycles)
+{
+	if ((int32_t)cycles < 0) cycles = 0;	// shorter than the calibrated overhead
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		count++;
+		// halve the sum and its count, rather than dividing a 64-bit sum later
+		while (total + cycles < cycles) {
+			if (avg_n & 1) {	// drop one average measurement first, to keep the average
+				total -= total / avg_n;
+				avg_n--;
+			}
+			total >>= 1;
+			avg_n >>= 1;
+		}
+		total += cycles;
+		avg_n++;
+		if (cycles < min) min = cycles;
+		if (cycles > max) max = cycles;
+	}
+}
+
+
+/// @brief average cycles per measurement, 0 if none
+uint32_t AvrStopwatch::Region::mean(void)
+{
+	uint32_t t, n;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		t = total;
+		n = avg_n;
+	}
+	return n ? t / n : 0;
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Measure the overhead of an empty region, to be subtracted from all 
+ * measurements. Call once after Timer1 has been started.
+ */
+void AvrStopwatch::calibrate(void)
+{
+	AvrTimer1* t = AvrTimer1::theInstance;
+	uint32_t start, end;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		start = t->cycles_now();
+		end = t->cycles_now();
+	}
+	s_overhead = end - start;
+}
+
+
+/// @brief clear the statistics of all regions
+void AvrStopwatch::reset_all(void)
+{
+	for (Region* r = s_first; r; r = r->next) 
+		r->reset();
+}
+
+//---------------------------------------------------------------------------
+
+#if DEBUG_AVRTIMERS
+
+/// @brief print the statistics of all regions
+void AvrStopwatch::print(void)
+{
+	for (Region* r = s_first; r; r = r->next) {
+		if (!r->count) continue;
+		DEBUG_PRINTF("%s: n=%lu min=%lu avg=%lu max=%lu cycles\r\n", 
+			r->name, r->count, r->min, r->mean(), r->max );
+	}
+}
+
+#endif // DEBUG_AVRTIMERS
+
+/** @} */
+
+#endif // AVRTIMERS_STOPWATCH
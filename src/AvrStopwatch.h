@@ -0,0 +1,96 @@
+/**
+ * @file 		  AvrStopwatch.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrStopwatch.h $
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRSTOPWATCH_H_
+#define AVRSTOPWATCH_H_
+
+#include <stdint.h>
+#include "AvrTimers.h"
+
+#if AVRTIMERS_STOPWATCH
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+/**
+ * @brief Measure CPU cycles spent in a scope, with Timer1 as cycle counter.
+ * 
+ * Requires `AVRTIMERS_STOPWATCH` !=0, and Timer1 initialized with 
+ * AvrTimer1::begin_cycles() (or any begin() with prescaler 1) and started.
+ * Each Region is a named set of statistics. An AvrStopwatch object takes 
+ * the cycle count when constructed, and adds the elapsed cycles to its 
+ * Region when it goes out of scope:
+ * 
+ * ```C++
+ * AvrStopwatch::Region r_filter("filter");
+ * 
+ * void filter() {
+ *     AvrStopwatch sw(r_filter);
+ *     ...
+ * }
+ * ```
+ * The cycles needed for the measurement itself are subtracted, see calibrate().
+ * Time spent in interrupts during the measurement is included.
+ */
+class AvrStopwatch {
+public:
+	/// statistics for one measured region of code
+	class Region {
+	public:
+		const char* name;
+		uint32_t count;			///< # of measurements
+		uint32_t min;			///< fewest cycles
+		uint32_t max;			///< most cycles
+		uint32_t total;			///< sum of the last `avg_n` measurements [cycles]
+		uint32_t avg_n;			///< # of measurements in `total`, both are halved before the sum overflows
+		Region*  next;			///< next in list of all regions
+
+		Region(const char* name_);
+		void add(uint32_t cycles);
+		void reset(void);
+		uint32_t mean(void);
+	};
+
+	AvrStopwatch(Region& region) : m_region(region), 
+		m_start(AvrTimer1::theInstance->cycles_now()) {}
+	~AvrStopwatch() 
+		{ m_region.add( AvrTimer1::theInstance->cycles_now() - m_start - s_overhead ); }
+
+	static void calibrate(void);
+	/// @brief first region in the list of all regions
+	static Region* first(void) { return s_first; }
+	static void reset_all(void);
+#if DEBUG_AVRTIMERS
+	static void print(void);
+#endif
+
+protected:
+	Region&  m_region;
+	uint32_t m_start;
+
+	static Region* s_first;
+	static uint16_t s_overhead;		///< cycles measured for an empty region
+};
+
+/** @} */
+
+#endif // AVRTIMERS_STOPWATCH
+
+#endif // AVRSTOPWATCH_H_
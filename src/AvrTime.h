@@ -0,0 +1,192 @@
+/**
+ * @file 		  AvrTime.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrTime.h $
+ */
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRTIME_H_
+#define AVRTIME_H_
+
+#include <stdint.h>
+#include "AvrTimers.h"
+
+/**
+ * @addtogroup AvrTimers
+ * @{
+ */
+
+/// enable a template only if `B` is true, like std::enable_if
+template<bool B> struct avr_enable_if {};
+template<> struct avr_enable_if<true> { typedef int type; };
+
+/**
+ * @brief Time span, as a signed number of units of `US` microseconds.
+ *
+ * Durations of the same unit can be added, subtracted and compared.
+ * A duration converts implicitly to a finer unit (e.g. ms to us), and
+ * with avr_duration_cast() to a coarser one, truncating.
+ */
+template<uint32_t US>
+class AvrDuration {
+	int32_t m_n;
+public:
+	/// microseconds per unit
+	static const uint32_t US_PER_UNIT = US;
+
+	constexpr explicit AvrDuration(int32_t n=0) : m_n(n) {}
+	/// @brief lossless conversion from a coarser unit
+	template<uint32_t U2, typename avr_enable_if<(U2 > US) && (U2 % US)==0>::type = 0>
+	constexpr AvrDuration(AvrDuration<U2> d) : m_n( d.count() * (int32_t)(U2 / US) ) {}
+
+	/// @brief number of units
+	constexpr int32_t count() const { return m_n; }
+
+	constexpr AvrDuration operator+(AvrDuration d) const { return AvrDuration(m_n + d.m_n); }
+	constexpr AvrDuration operator-(AvrDuration d) const { return AvrDuration(m_n - d.m_n); }
+	constexpr AvrDuration operator-() const { return AvrDuration(-m_n); }
+	constexpr AvrDuration operator*(int32_t k) const { return AvrDuration(m_n * k); }
+	constexpr AvrDuration operator/(int32_t k) const { return AvrDuration(m_n / k); }
+	AvrDuration& operator+=(AvrDuration d) { m_n += d.m_n; return *this; }
+	AvrDuration& operator-=(AvrDuration d) { m_n -= d.m_n; return *this; }
+
+	constexpr bool operator==(AvrDuration d) const { return m_n == d.m_n; }
+	constexpr bool operator!=(AvrDuration d) const { return m_n != d.m_n; }
+	constexpr bool operator< (AvrDuration d) const { return m_n <  d.m_n; }
+	constexpr bool operator<=(AvrDuration d) const { return m_n <= d.m_n; }
+	constexpr bool operator> (AvrDuration d) const { return m_n >  d.m_n; }
+	constexpr bool operator>=(AvrDuration d) const { return m_n >= d.m_n; }
+};
+
+typedef AvrDuration<1>			AvrMicros;
+typedef AvrDuration<1000>		AvrMillis;
+typedef AvrDuration<1000000>	AvrSeconds;
+
+/// @brief convert a duration to another unit, truncating if the new unit is coarser
+template<class To, uint32_t US>
+constexpr To avr_duration_cast(AvrDuration<US> d)
+{
+	return To( (US >= To::US_PER_UNIT)
+		? d.count() * (int32_t)(US / To::US_PER_UNIT)
+		: d.count() / (int32_t)(To::US_PER_UNIT / US) );
+}
+
+constexpr AvrMicros  operator"" _us(unsigned long long n) { return AvrMicros((int32_t)n); }
+constexpr AvrMillis  operator"" _ms(unsigned long long n) { return AvrMillis((int32_t)n); }
+constexpr AvrSeconds operator"" _s (unsigned long long n) { return AvrSeconds((int32_t)n); }
+
+//---------------------------------------------------------------------------
+
+/// @brief clock for AvrInstant: the global `millis()` counter
+struct AvrMillisClock {
+	typedef AvrMillis duration;
+	static uint32_t now() { return millis(); }
+};
+
+/// @brief clock for AvrInstant: `get_millis()` of timer `ID`
+template<uint8_t ID>
+struct AvrTimerMillisClock {
+	typedef AvrMillis duration;
+	static uint32_t now() { return AvrTimerBase::s_timers[ID]->get_millis(); }
+};
+
+/// @brief clock for AvrInstant: `get_micros()` of timer `ID`
+template<uint8_t ID>
+struct AvrTimerMicrosClock {
+	typedef AvrMicros duration;
+	static uint32_t now() { return AvrTimerBase::s_timers[ID]->get_micros(); }
+};
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Point in time of a `Clock`, which wraps around at 2^32 units.
+ *
+ * Differences and comparisons are correct across the wrap-around, as long
+ * as the instants are less than 2^31 units apart (24.8 days for millis,
+ * 35 minutes for micros).
+ */
+template<class Clock>
+class AvrInstant {
+	uint32_t m_t;
+public:
+	typedef typename Clock::duration duration;
+
+	constexpr explicit AvrInstant(uint32_t t=0) : m_t(t) {}
+	/// @brief current time of the clock
+	static AvrInstant now() { return AvrInstant(Clock::now()); }
+	/// @brief raw counter value
+	constexpr uint32_t raw() const { return m_t; }
+	/// @brief time since this instant
+	duration elapsed() const { return now() - *this; }
+
+	constexpr duration operator-(AvrInstant t) const { return duration( (int32_t)(m_t - t.m_t) ); }
+	constexpr AvrInstant operator+(duration d) const { return AvrInstant( m_t + (uint32_t)d.count() ); }
+	constexpr AvrInstant operator-(duration d) const { return AvrInstant( m_t - (uint32_t)d.count() ); }
+	AvrInstant& operator+=(duration d) { m_t += (uint32_t)d.count(); return *this; }
+	AvrInstant& operator-=(duration d) { m_t -= (uint32_t)d.count(); return *this; }
+
+	constexpr bool operator==(AvrInstant t) const { return m_t == t.m_t; }
+	constexpr bool operator!=(AvrInstant t) const { return m_t != t.m_t; }
+	constexpr bool operator< (AvrInstant t) const { return (int32_t)(m_t - t.m_t) <  0; }
+	constexpr bool operator<=(AvrInstant t) const { return (int32_t)(m_t - t.m_t) <= 0; }
+	constexpr bool operator> (AvrInstant t) const { return (int32_t)(m_t - t.m_t) >  0; }
+	constexpr bool operator>=(AvrInstant t) const { return (int32_t)(m_t - t.m_t) >= 0; }
+};
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Point in time by which something must happen, for timeouts and periodic jobs.
+ *
+ * ```C++
+ * AvrDeadline<AvrMillisClock> next(100_ms);
+ * while (1) {
+ *     if (next.expired()) {
+ *         next.advance(100_ms);	// every 100 ms, without drift
+ *         ...
+ *     }
+ * }
+ * ```
+ */
+template<class Clock>
+class AvrDeadline {
+public:
+	typedef AvrInstant<Clock> instant;
+	typedef typename Clock::duration duration;
+
+	/// @brief deadline that has already expired
+	AvrDeadline() : m_end(instant::now()) {}
+	/// @brief deadline `timeout` from now
+	explicit AvrDeadline(duration timeout) : m_end(instant::now() + timeout) {}
+
+	/// @brief set the deadline to `timeout` from now
+	void start(duration timeout) { m_end = instant::now() + timeout; }
+	/// @brief move the deadline by `period`, e.g. for the next run of a periodic job
+	void advance(duration period) { m_end += period; }
+	/// @brief true if the deadline has passed
+	bool expired() const { return instant::now() >= m_end; }
+	/// @brief time left until the deadline, 0 if it has passed
+	duration remaining() const {
+		duration d = m_end - instant::now();
+		return (d.count() > 0) ? d : duration(0);
+	}
+	constexpr instant end() const { return m_end; }
+protected:
+	instant m_end;
+};
+
+/** @} */
+
+#endif // AVRTIME_H_
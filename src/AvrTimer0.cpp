@@ -32,6 +32,7 @@
 
 
 AvrTimer0* AvrTimer0::theInstance = NULL;
+constexpr uint32_t AvrTimer0::T0_div[];
 
 #define T0WGM 7
 
@@ -40,12 +41,19 @@ AvrTimer0* AvrTimer0::theInstance = NULL;
 
 //---------------------------------------------------------------------------
 
-ISR (TIMER0_COMPA_vect)
+#ifndef AVRTIMER0_CUSTOM_ISR
+
+ISR (AVRTIMER0_vect)
 {
-	sei();
+	AVRTIMERS_ISR_ENTER();
+	AVRTIMERS_NEST_BEGIN( AVRTIMER0_NESTING, AvrTimer0::theInstance, TIMSK0, AVRTIMER0_IE );
 	AvrTimer0::theInstance->call_tasks();
+	AVRTIMERS_NEST_END( AVRTIMER0_NESTING, AvrTimer0::theInstance, TIMSK0, AVRTIMER0_IE );
+	AVRTIMERS_ISR_EXIT();
 }
 
+#endif // AVRTIMER0_CUSTOM_ISR
+
 /** 
  * @addtogroup AvrTimers
  * @{ 
@@ -53,30 +61,53 @@ ISR (TIMER0_COMPA_vect)
 
 //---------------------------------------------------------------------------
 
-AvrTimer0::AvrTimer0(void) : AvrTimerBase()
+AvrTimer0::AvrTimer0(void) : AvrTimerBase(0)
 {
 	AvrTimer0::theInstance = this;
+#if AVRTIMERS_IDLE_SCALING && !AVRTIMER0_SHARED
+	m_retune = retune;
+#endif
 }
 
 //---------------------------------------------------------------------------
 
-/** @brief start TC0 interrupts. */
+/** @brief start TC0 interrupts, switch the timer on again if it was stopped. */
 void AvrTimer0::start(void)
 {
+#if AVRTIMER0_SHARED
+	TIFR0   = _BV(OCF0B);						// clear interrupt
+	TIMSK0 |= _BV(OCIE0B);						// enable compare match B, keep the core's overflow interrupt
+#else
+	power_on();
 	TIFR0  = _BV(OCF0A);						// clear interrupt
 	TIMSK0 = _BV(OCIE0A);						// enable output compare match A interrupt
+#endif
 }
 
 //---------------------------------------------------------------------------
 
-/** @brief stop TC0 interrupts. */
+/** 
+ * @brief stop TC0 interrupts. If no task, millis or PWM output depends on the 
+ * timer, also switch it off via PRR to save power, until start() is called.
+ */
 void AvrTimer0::stop(void)
 {
-	TIMSK0 &= ~_BV(OCIE0A);						// enable overflow interrupt
+#if AVRTIMER0_NESTING == AVRTIMERS_NEST_OTHERS
+	m_nest_masked = 0;							// keep the ISR from enabling it again
+#endif
+#if AVRTIMER0_SHARED
+	TIMSK0 &= ~_BV(OCIE0B);						// disable compare match B, the timer keeps running for the core
+#else
+	TIMSK0 &= ~_BV(OCIE0A);						// disable compare match A interrupt
+	if (!m_enableB && !has_tasks()) 
+		power_off();
+#endif
 }
 
 //---------------------------------------------------------------------------
 
+#if !AVRTIMER0_SHARED
+
 /** 
  * @brief set PWM duty cycle on OCR0B
  * @param pwm  duty cycle between 0 and `top`
@@ -93,6 +124,9 @@ void AvrTimer0::setPWM_B(uint8_t pwm, uint8_t top )
 		SET( PIN_OC0B, m_comB==3 );
 	}
 	setCR();
+#if AVRTIMERS_IDLE_SCALING
+	if (m_enableB != m_hold_rate) hold_rate( m_enableB );
+#endif
 }
 
 //---------------------------------------------------------------------------
@@ -111,6 +145,7 @@ uint32_t AvrTimer0::init(
 	if (cs==0) return 0;	// T0 rate too low
 
     PRR &= ~_BV(PRTIM0);
+	m_gated = false;
 
 	m_polB = polB;
 	m_comB = polB ? ((polB==ActiveHigh) ? 2 : 3 ) : 0;
@@ -135,25 +170,169 @@ uint32_t AvrTimer0::init(
 
 	TIFR0  = _BV(TOV0)|_BV(OCF0A)|_BV(OCF0B);	// clear interrupts
 
-	if (arate <= 1000) {
-		m_MillisPerTick = 1000 / arate;
-		m_TicksPerMilli = 1;
-	} else {
-		m_TicksPerMilli = arate / 1000;
-		m_MillisPerTick = 0;
-	}
+	set_timebase( fclk, T0_div[cs], ocr+1 );
+#if AVRTIMERS_IDLE_SCALING
+	m_cs0 = cs;
+	m_ocr0 = ocr+1;
+	m_hold_rate = m_enableB;
+	reset_rate_div();
+#endif
+
+#if AVRTIMERS_PERSIST
+	restore_millis();
+#endif
 
 #if DEBUG_AVRTIMERS
 	DEBUG_PRINTF(" T0: F=%lu, CS=%u, OCR=%u, rate is %lu, ",
 		fclk, (unsigned)cs, (unsigned)ocr, arate );
-	DEBUG_PRINTF("%d %s\r\n", 
-		m_MillisPerTick ? m_MillisPerTick : m_TicksPerMilli,
-		m_MillisPerTick ? "ms/t" : "t/ms" );
+	DEBUG_PRINTF("%u+%lu/2^32 ms/t\r\n", m_MillisPerTick, m_FracPerTick );
+#endif // DEBUG_AVRTIMERS
+
+	return arate;
+}
+
+#endif // !AVRTIMER0_SHARED
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMER0_SHARED
+
+/** 
+ * @brief Use TC0 as configured by the Arduino core (fast PWM, TOP=0xFF, 
+ * overflow interrupt for `millis()`), and run tasks from the compare match B 
+ * interrupt, once per timer cycle, at a fixed phase between two overflows. 
+ * The timer configuration is not changed, only OCR0B is set, so `analogWrite()`
+ * on OC0B (Arduino pin 5 on the ATmega328P) must not be used.
+ * Call start() to enable the interrupt.
+ * @param phase  counter value at which the tasks run, 0..255
+ * @return actual rate [Hz], e.g. 976 at 16 MHz, or 0 if TC0 is not in fast PWM mode
+ */
+uint32_t AvrTimer0::begin_shared(uint8_t phase)
+{
+	uint8_t cs = TCCR0B & (7 << CS00);
+	uint8_t wgm = (TCCR0A & 3) | ((TCCR0B >> WGM02) & 1) << 2;
+	if (cs==0 || cs>5 || wgm!=3) return 0;
+
+	const uint32_t fclk = F_CPU;
+	uint32_t arate = fclk / (T0_div[cs] * 256);
+
+	m_gated = false;
+	m_ocr = 0xFF;
+	OCR0B = phase;
+	TIFR0 = _BV(OCF0B);
+
+	set_timebase( fclk, T0_div[cs], 256 );
+
+#if AVRTIMERS_PERSIST
+	restore_millis();
+#endif
+
+#if DEBUG_AVRTIMERS
+	DEBUG_PRINTF(" T0 shared: F=%lu, CS=%u, phase=%u, rate is %lu, ",
+		fclk, (unsigned)cs, (unsigned)phase, arate );
+	DEBUG_PRINTF("%u+%lu/2^32 ms/t\r\n", m_MillisPerTick, m_FracPerTick );
 #endif // DEBUG_AVRTIMERS
 
 	return arate;
 }
 
+#endif // AVRTIMER0_SHARED
+
+//---------------------------------------------------------------------------
+
+#if !AVRTIMER0_SHARED
+
+#if AVRTIMERS_MAX_CLKPS
+
+/** 
+ * @brief Precompute timer configurations for each system clock prescaler.
+ * @param rate  desired interrupt rate [Hz]
+ */
+void AvrTimer0::prepare_clocks(uint32_t rate)
+{
+	for (uint8_t k=0; k<=AVRTIMERS_MAX_CLKPS; k++) {
+		clkcfg_t& c = m_clkcfg[k];
+		uint32_t fclk = F_CPU >> k;
+		c.cs = calc_cs( fclk, rate );
+		c.ocr = calc_ocr( fclk, rate );
+		if (c.cs) calc_timebase( c.tb, fclk, T0_div[c.cs], c.ocr );
+	}
+	m_reclock = reclock;
+}
+
+
+/** 
+ * @brief Reprogram TC0 for a new system clock prescaler, keeping counter phase
+ * and PWM duty cycle. Called from set_clock_prescaler() with interrupts disabled.
+ */
+void AvrTimer0::reclock(uint8_t clkps)
+{
+	AvrTimer0* t = theInstance;
+	const clkcfg_t& c = t->m_clkcfg[clkps];
+	t->load( c.cs, c.ocr-1 );
+	t->set_timebase( c.tb );
+#if AVRTIMERS_IDLE_SCALING
+	t->m_cs0 = c.cs;
+	t->m_ocr0 = c.ocr;
+#endif
+}
+
+#endif // AVRTIMERS_MAX_CLKPS
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_IDLE_SCALING
+
+/** 
+ * @brief Reprogram TC0 for nominal rate / `div`, keeping the exact tick period.
+ * Called with interrupts disabled.
+ * @return false if the rate can't be achieved, or PWM is active
+ */
+bool AvrTimer0::retune(uint16_t div, bool at_tick)
+{
+	AvrTimer0* t = theInstance;
+	if (div > 1 && t->m_hold_rate) return false;	// would change PWM frequency
+
+	uint32_t cycles = (uint32_t)div * T0_div[t->m_cs0] * t->m_ocr0;
+	for (uint8_t cs=1; cs<=5; cs++) {
+		uint32_t ocr = cycles / T0_div[cs];
+		if (ocr <= 256 && ocr * T0_div[cs] == cycles) {
+			t->load( cs, ocr-1, at_tick );
+			t->set_timebase( F_CPU >> s_clkps, T0_div[cs], ocr );
+			return true;
+		}
+	}
+	return false;
+}
+
+#endif // AVRTIMERS_IDLE_SCALING
+
+//---------------------------------------------------------------------------
+
+/** 
+ * @brief Change clock select and TOP of a running timer, keeping PWM duty cycle,
+ * and counter phase, or with `at_tick` the time since the last compare match.
+ * Called with interrupts disabled.
+ */
+void AvrTimer0::load(uint8_t cs, uint8_t top, bool at_tick)
+{
+	uint8_t old = m_ocr;
+	uint8_t n = TCNT0;
+
+	if (at_tick) {
+		// the compare flag is set when the counter is at TOP, count from there
+		// plus half a count of the old prescaler, on average
+		uint16_t d = T0_div[TCCR0B & 7];
+		uint32_t c = ((uint32_t)((n == old) ? 0 : n+1) * d + d/2) / T0_div[cs];
+		n = (c == 0) ? 0 : (c < top) ? c-1 : top-1;	// writing TOP would block the compare match
+	} else
+		n = ((uint16_t)n * top) / old;
+	TCCR0B = (TCCR0B & ~(7 << CS00)) | (cs << CS00);
+	TCNT0 = n;
+	OCR0B = ((uint16_t)OCR0B * top) / old;
+	OCR0A = m_ocr = top;
+}
+
 //---------------------------------------------------------------------------
 
 /** @brief program timer for current pulse width */
@@ -165,4 +344,6 @@ void AvrTimer0::setCR()
 			;
 }
 
+#endif // !AVRTIMER0_SHARED
+
 /** @} */
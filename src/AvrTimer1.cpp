@@ -40,13 +40,24 @@
 //---------------------------------------------------------------------------
 
 AvrTimer1* AvrTimer1::theInstance = NULL;
+constexpr uint32_t AvrTimer1::T1_div[];
+
+#ifndef AVRTIMER1_CUSTOM_ISR
 
 ISR(TIMER1_OVF_vect)
 {
-	sei();
+	AVRTIMERS_ISR_ENTER();
+#if AVRTIMERS_STOPWATCH
+	AvrTimer1::theInstance->count_cycles();
+#endif
+	AVRTIMERS_NEST_BEGIN( AVRTIMER1_NESTING, AvrTimer1::theInstance, TIMSK1, TOIE1 );
 	AvrTimer1::theInstance->call_tasks();
+	AVRTIMERS_NEST_END( AVRTIMER1_NESTING, AvrTimer1::theInstance, TIMSK1, TOIE1 );
+	AVRTIMERS_ISR_EXIT();
 }
 
+#endif // AVRTIMER1_CUSTOM_ISR
+
 //---------------------------------------------------------------------------
 
 /** 
@@ -57,10 +68,18 @@ ISR(TIMER1_OVF_vect)
 /**
  * @brief Constructor, initialize timer variables
  */
-AvrTimer1::AvrTimer1(void) : AvrTimerBase(), 
+AvrTimer1::AvrTimer1(void) : AvrTimerBase(1), 
 	m_enableA(false), m_enableB(false)
 {
+#if AVRTIMERS_STOPWATCH
+	m_cycles = 0;
+	m_ovf_cycles = 0;
+	m_cycle_div = 1;
+#endif
 	AvrTimer1::theInstance = this;
+#if AVRTIMERS_IDLE_SCALING
+	m_retune = retune;
+#endif
 }
 
 //---------------------------------------------------------------------------
@@ -84,6 +103,7 @@ uint32_t AvrTimer1::init(
 	}
 
     PRR &= ~_BV(PRTIM1);
+	m_gated = false;
 
 	m_polA = polA;
 	m_polB = polB;
@@ -105,26 +125,31 @@ uint32_t AvrTimer1::init(
 	// Control Register B for Timer/Counter-0 (Timer/Counter-0 is configured using two registers: A and B)
 	// TCCR0B is [FOC0A:FOC0B:unused:unused:WGM02:CS02:CS01:CS00]
 	TCCR1B	= (T1WGM>>2) << WGM12
-			| 1 << CS10				// CS1[2:0]=1  clock is ClkIO/1 = 1 MHz = 100 Hz PWM reload rate
+			| cs << CS10			// CS1[2:0]  clock is ClkIO/T1_div[cs]
 			;
 	ICR1 = m_top = ocr-1;                // initial state is 100% on
+#if AVRTIMERS_STOPWATCH
+	set_cycles( cs, m_top );
+#endif
 
 	TIFR1  = 0xFF;	// clear all interrupts
 
-	if (arate <= 1000) {
-		m_MillisPerTick = 1000 / arate;
-		m_TicksPerMilli = 1;
-	} else {
-		m_TicksPerMilli = arate / 1000;
-		m_MillisPerTick = 0;
-	}
+	set_timebase( fclk, T1_div[cs], ocr );
+#if AVRTIMERS_IDLE_SCALING
+	m_cs0 = cs;
+	m_ocr0 = ocr;
+	m_hold_rate = m_enableA || m_enableB;
+	reset_rate_div();
+#endif
+
+#if AVRTIMERS_PERSIST
+	restore_millis();
+#endif
 
 #if DEBUG_AVRTIMERS
 	DEBUG_PRINTF(" T1: F=%lu, CS=%u, TOP=%u, rate %lu, ",
 		fclk, cs, m_top, arate);
-	DEBUG_PRINTF("%u %s\r\n",
-		m_MillisPerTick ? m_MillisPerTick : m_TicksPerMilli,
-		m_MillisPerTick ? "ms/t" : "t/ms" );
+	DEBUG_PRINTF("%u+%lu/2^32 ms/t\r\n", m_MillisPerTick, m_FracPerTick );
 #endif // DEBUG_AVRTIMERS
 
 	return arate;	
@@ -132,21 +157,160 @@ uint32_t AvrTimer1::init(
 
 //---------------------------------------------------------------------------
 
-/** @brief start TC1 interrupts. */
+/** @brief start TC1 interrupts, switch the timer on again if it was stopped. */
 void AvrTimer1::start(void)
 {
+	power_on();
 	TIFR1  = _BV(TOIE1); 		// clear interrupt
 	TIMSK1 = _BV(TOIE1);	    	// enable overflow interrupt
 }
 
 //---------------------------------------------------------------------------
 
-/** @brief stop TC1 interrupts. */
+/** 
+ * @brief stop TC1 interrupts. If no task, millis or PWM output depends on the 
+ * timer, also switch it off via PRR to save power, until start() is called.
+ */
 void AvrTimer1::stop(void)
 {
-	TIMSK1 &= ~_BV(TOIE1);						// enable overflow interrupt
+#if AVRTIMER1_NESTING == AVRTIMERS_NEST_OTHERS
+	m_nest_masked = 0;							// keep the ISR from enabling it again
+#endif
+	TIMSK1 &= ~_BV(TOIE1);						// disable overflow interrupt
+	if (!m_enableA && !m_enableB && !has_tasks()) 
+		power_off();
+}
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_MAX_CLKPS
+
+/** 
+ * @brief Precompute timer configurations for each system clock prescaler.
+ * @param rate  desired interrupt rate [Hz]
+ */
+void AvrTimer1::prepare_clocks(uint32_t rate)
+{
+	for (uint8_t k=0; k<=AVRTIMERS_MAX_CLKPS; k++) {
+		clkcfg_t& c = m_clkcfg[k];
+		uint32_t fclk = F_CPU >> k;
+		c.cs = calc_cs( fclk, rate );
+		c.ocr = calc_ocr( fclk, rate );
+		if (c.cs) calc_timebase( c.tb, fclk, T1_div[c.cs], c.ocr );
+	}
+	m_reclock = reclock;
+}
+
+
+/** 
+ * @brief Reprogram TC1 for a new system clock prescaler, keeping counter phase
+ * and PWM duty cycles. Called from set_clock_prescaler() with interrupts disabled.
+ */
+void AvrTimer1::reclock(uint8_t clkps)
+{
+	AvrTimer1* t = theInstance;
+	const clkcfg_t& c = t->m_clkcfg[clkps];
+	t->load( c.cs, c.ocr-1 );
+	t->set_timebase( c.tb );
+#if AVRTIMERS_IDLE_SCALING
+	t->m_cs0 = c.cs;
+	t->m_ocr0 = c.ocr;
+#endif
+}
+
+#endif // AVRTIMERS_MAX_CLKPS
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_IDLE_SCALING
+
+/** 
+ * @brief Reprogram TC1 for nominal rate / `div`, keeping the exact tick period.
+ * Called with interrupts disabled.
+ * @return false if the rate can't be achieved, or PWM is active
+ */
+bool AvrTimer1::retune(uint16_t div, bool at_tick)
+{
+	AvrTimer1* t = theInstance;
+	if (div > 1 && t->m_hold_rate) return false;	// would change PWM frequency
+
+	uint32_t cycles = (uint32_t)div * T1_div[t->m_cs0] * t->m_ocr0;
+	for (uint8_t cs=1; cs<=5; cs++) {
+		uint32_t ocr = cycles / T1_div[cs];
+		if (ocr < 32767uL && ocr * T1_div[cs] == cycles) {
+			t->load( cs, ocr-1, at_tick );
+			t->set_timebase( F_CPU >> s_clkps, T1_div[cs], ocr );
+			return true;
+		}
+	}
+	return false;
+}
+
+#endif // AVRTIMERS_IDLE_SCALING
+
+//---------------------------------------------------------------------------
+
+/** 
+ * @brief Change clock select and TOP of a running timer, keeping PWM duty cycles,
+ * and counter phase, or with `at_tick` the time since the last compare match.
+ * Called with interrupts disabled.
+ */
+void AvrTimer1::load(uint8_t cs, uint16_t top, bool at_tick)
+{
+	uint16_t old = m_top;
+	uint16_t n = TCNT1;
+
+	if (at_tick) {
+		// the overflow flag is set when the counter is at TOP, count from there
+		// plus half a count of the old prescaler, on average
+		uint16_t d = T1_div[TCCR1B & 7];
+		uint32_t c = ((uint32_t)((n == old) ? 0 : n+1) * d + d/2) / T1_div[cs];
+		n = (c == 0) ? 0 : (c < top) ? c-1 : top-1;	// writing TOP would block the compare match
+	} else
+		n = ((uint32_t)n * top) / old;
+	TCCR1B	= (T1WGM>>2) << WGM12
+			| cs << CS10
+			;
+	TCNT1 = n;
+	OCR1A = ((uint32_t)OCR1A * top) / old;
+	OCR1B = ((uint32_t)OCR1B * top) / old;
+	ICR1 = m_top = top;
+#if AVRTIMERS_STOPWATCH
+	set_cycles( cs, top );
+#endif
+}
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_STOPWATCH
+
+/** 
+ * @brief CPU cycles since Timer1 was initialized, modulo 2^32. Resolution is 
+ * one cycle if Timer1 runs from the CPU clock, see begin_cycles().
+ * Counts cycles of the current CPU clock, if the system clock prescaler is used.
+ */
+uint32_t AvrTimer1::cycles_now(void)
+{
+	uint32_t cycles;
+	uint16_t counts;
+	bool pending;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		cycles = m_cycles;
+		counts = read_counter(pending);
+	}
+	// the overflow flag is set when the counter is at TOP, count from there
+	counts = (counts == m_period-1) ? 0 : counts+1;
+	// overflow happened, but the ISR has not counted it yet
+	if (pending && counts < (m_period >> 1)) cycles += m_ovf_cycles;
+
+	if (m_cycle_div == 1) return cycles + counts;
+	return cycles + (uint32_t)counts * m_cycle_div;
 }
 
+#endif // AVRTIMERS_STOPWATCH
+
 //---------------------------------------------------------------------------
 
 void AvrTimer1::setCR()
@@ -174,6 +338,9 @@ void AvrTimer1::setPWM_A(uint16_t pwm, uint16_t top)
 		SET( PIN_OC1A, m_comA==3);
 	}
 	setCR();
+#if AVRTIMERS_IDLE_SCALING
+	if ((m_enableA || m_enableB) != m_hold_rate) hold_rate( m_enableA || m_enableB );
+#endif
 }
 
 //---------------------------------------------------------------------------
@@ -193,6 +360,9 @@ void AvrTimer1::setPWM_B(uint16_t pwm, uint16_t top )
 		SET( PIN_OC1B, m_comB==3);
 	}
 	setCR();
+#if AVRTIMERS_IDLE_SCALING
+	if ((m_enableA || m_enableB) != m_hold_rate) hold_rate( m_enableA || m_enableB );
+#endif
 }
 
 /** @} */
@@ -33,6 +33,7 @@
 #endif
 
 AvrTimer2* AvrTimer2::theInstance = NULL;
+constexpr uint32_t AvrTimer2::T2_div[];
 
 //---------------------------------------------------------------------------
 
@@ -40,8 +41,11 @@ AvrTimer2* AvrTimer2::theInstance = NULL;
 
 ISR (TIMER2_COMPA_vect)
 {
-	sei();
+	AVRTIMERS_ISR_ENTER();
+	AVRTIMERS_NEST_BEGIN( AVRTIMER2_NESTING, AvrTimer2::theInstance, TIMSK2, OCIE2A );
 	AvrTimer2::theInstance->isr();
+	AVRTIMERS_NEST_END( AVRTIMER2_NESTING, AvrTimer2::theInstance, TIMSK2, OCIE2A );
+	AVRTIMERS_ISR_EXIT();
 }
 
 #endif // AVRTIMER2_CUSTOM_ISR
@@ -53,9 +57,12 @@ ISR (TIMER2_COMPA_vect)
 
 //---------------------------------------------------------------------------
 
-AvrTimer2::AvrTimer2(void) : AvrTimerBase()
+AvrTimer2::AvrTimer2(void) : AvrTimerBase(2)
 {
 	AvrTimer2::theInstance = this;
+#if AVRTIMERS_IDLE_SCALING
+	m_retune = retune;
+#endif
 }
 
 //---------------------------------------------------------------------------
@@ -73,8 +80,8 @@ AvrTimer2::AvrTimer2(void) : AvrTimerBase()
 uint32_t AvrTimer2::set_rate(uint8_t cs, uint8_t ocr, uint8_t pre, uint32_t fclk, bool async)
 {
 	if (cs==0) return 0;	// T2 rate too low
-	m_prescale = pre;
 	m_async = async;
+	m_fclk = fclk;
 
 	TCCR2B	= (cs << CS20)	// clock source, e.g. CLKio/1024: TCCR2B.CS[2:0]=111
 			| (0 << WGM22)
@@ -85,21 +92,19 @@ uint32_t AvrTimer2::set_rate(uint8_t cs, uint8_t ocr, uint8_t pre, uint32_t fclk
 
 	uint32_t arate = fclk / (AvrTimer2::T2_div[cs] * ocr);
 
-	uint32_t atick = arate / m_prescale;
-	if (atick <= 1000) {
-		m_MillisPerTick = 1000 / atick;
-		m_TicksPerMilli = 1;
-	} else {
-		m_TicksPerMilli = atick / 1000;
-		m_MillisPerTick = 0;
-	}
+	set_timebase( fclk, T2_div[cs], ocr, pre );
+#if AVRTIMERS_IDLE_SCALING
+	m_cs0 = cs;
+	m_ocr0 = ocr;
+	m_hold_rate = (m_isr != NULL);
+	reset_rate_div();
+#endif
 
 #if DEBUG_AVRTIMERS
+	uint32_t atick = arate / pre;
 	DEBUG_PRINTF(" T2: F=%ld, CS=%u, OCR=%u, rate %lu Hz, %lu t/s, ",
 		fclk, (unsigned)cs, (unsigned)ocr, arate, atick );
-	DEBUG_PRINTF("%d %s\r\n",
-		m_MillisPerTick ? m_MillisPerTick : m_TicksPerMilli,
-		m_MillisPerTick ? "ms/t" : "t/ms" );
+	DEBUG_PRINTF("%u+%lu/2^32 ms/t\r\n", m_MillisPerTick, m_FracPerTick );
 #endif // DEBUG_AVRTIMERS
 
 	return arate;
@@ -121,6 +126,7 @@ uint32_t AvrTimer2::init(
 {
 	if (cs==0) return 0;	// T2 rate too low
     PRR &= ~_BV(PRTIM2);   
+	m_gated = false;
 	m_isr = isr;
 	TIMSK2 = 0;						// disable all T2 interrrupts
 	if (async) ASSR |= _BV(AS2);
@@ -130,24 +136,133 @@ uint32_t AvrTimer2::init(
 			;
 	uint32_t arate = set_rate(cs,ocr,pre,fclk,async);
 	TIFR2  = _BV(TOV2)|_BV(OCF2A)|_BV(OCF2B);	// clear interrupts
+#if AVRTIMERS_PERSIST
+	restore_millis();
+#endif
 	return arate;
 }
 
 //---------------------------------------------------------------------------
 
-/** @brief start TC2 interrupts. */
+#if AVRTIMERS_MAX_CLKPS
+
+/** 
+ * @brief Precompute timer configurations for each system clock prescaler.
+ * Not used in async mode, where T2 is independent of the system clock.
+ * @param rate  desired interrupt rate [Hz]
+ * @param fclk  T2 clock rate at full system clock [Hz]
+ */
+void AvrTimer2::prepare_clocks(uint32_t rate, uint32_t fclk)
+{
+	for (uint8_t k=0; k<=AVRTIMERS_MAX_CLKPS; k++) {
+		clkcfg_t& c = m_clkcfg[k];
+		uint32_t f = fclk >> k;
+		c.cs = calc_cs( f, rate );
+		c.ocr = calc_ocr( f, rate );
+		if (c.cs) calc_timebase( c.tb, f, T2_div[c.cs], c.ocr, m_prescale );
+	}
+	m_reclock = reclock;
+}
+
+
+/** 
+ * @brief Reprogram TC2 for a new system clock prescaler, keeping counter phase.
+ * Called from set_clock_prescaler() with interrupts disabled.
+ */
+void AvrTimer2::reclock(uint8_t clkps)
+{
+	AvrTimer2* t = theInstance;
+	const clkcfg_t& c = t->m_clkcfg[clkps];
+	t->load( c.cs, c.ocr-1 );
+	t->set_timebase( c.tb );
+#if AVRTIMERS_IDLE_SCALING
+	t->m_cs0 = c.cs;
+	t->m_ocr0 = c.ocr;
+#endif
+}
+
+#endif // AVRTIMERS_MAX_CLKPS
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_IDLE_SCALING
+
+/** 
+ * @brief Reprogram TC2 for nominal rate / `div`, keeping the exact tick period.
+ * Called with interrupts disabled.
+ * @return false if the rate can't be achieved, or a per-interrupt function is set
+ */
+bool AvrTimer2::retune(uint16_t div, bool at_tick)
+{
+	AvrTimer2* t = theInstance;
+	if (div > 1 && t->m_hold_rate) return false;	// m_isr needs the nominal interrupt rate
+
+	uint32_t cycles = (uint32_t)div * T2_div[t->m_cs0] * t->m_ocr0;
+	for (uint8_t cs=1; cs<=7; cs++) {
+		uint32_t ocr = cycles / T2_div[cs];
+		if (ocr <= 256 && ocr * T2_div[cs] == cycles) {
+			t->load( cs, ocr-1, at_tick );
+			uint32_t fclk = t->m_async ? t->m_fclk : (t->m_fclk >> s_clkps);
+			t->set_timebase( fclk, T2_div[cs], ocr, t->m_prescale );
+			return true;
+		}
+	}
+	return false;
+}
+
+#endif // AVRTIMERS_IDLE_SCALING
+
+//---------------------------------------------------------------------------
+
+/** 
+ * @brief Change clock select and TOP of a running timer, keeping counter phase,
+ * or with `at_tick` the time since the last compare match. 
+ * Called with interrupts disabled.
+ */
+void AvrTimer2::load(uint8_t cs, uint8_t top, bool at_tick)
+{
+	uint8_t old = m_ocr;
+	uint8_t n = TCNT2;
+
+	if (at_tick) {
+		// the compare flag is set when the counter is at TOP, count from there
+		// plus half a count of the old prescaler, on average
+		uint16_t d = T2_div[TCCR2B & 7];
+		uint32_t c = ((uint32_t)((n == old) ? 0 : n+1) * d + d/2) / T2_div[cs];
+		n = (c == 0) ? 0 : (c < top) ? c-1 : top-1;	// writing TOP would block the compare match
+	} else
+		n = ((uint16_t)n * top) / old;
+	TCCR2B = (TCCR2B & ~(7 << CS20)) | (cs << CS20);
+	TCNT2 = n;
+	OCR2A = m_ocr = top;
+	if (m_async)
+		while (ASSR & (_BV(TCN2UB)|_BV(OCR2AUB)|_BV(TCR2BUB))) {}
+}
+
+//---------------------------------------------------------------------------
+
+/** @brief start TC2 interrupts, switch the timer on again if it was stopped. */
 void AvrTimer2::start(void)
 {
+	power_on();
 	TIFR2  = _BV(OCF2A);						// clear interrupt
 	TIMSK2 = _BV(OCIE2A);						// enable overflow interrupt
 }
 
 //---------------------------------------------------------------------------
 
-/** @brief stop TC2 interrupts. */
+/** 
+ * @brief stop TC2 interrupts. If no task, millis or per-interrupt function 
+ * depends on the timer, also switch it off via PRR to save power, until start() is called.
+ */
 void AvrTimer2::stop(void)
 {
-	TIMSK2 &= ~_BV(OCIE2A);						// enable overflow interrupt
+#if AVRTIMER2_NESTING == AVRTIMERS_NEST_OTHERS
+	m_nest_masked = 0;							// keep the ISR from enabling it again
+#endif
+	TIMSK2 &= ~_BV(OCIE2A);						// disable compare match A interrupt
+	if (!m_isr && !has_tasks()) 
+		power_off();
 }
 
 //---------------------------------------------------------------------------
@@ -155,17 +270,26 @@ void AvrTimer2::stop(void)
 /// @brief Update `millis` etc counters, and call all registered callback functions 
 void AvrTimer2::isr(void)
 {
-	static uint8_t precount=1;
-	
 	if (m_async)
 		OCR2A = m_ocr;
 
-	if (m_isr) m_isr();
-	if (--precount == 0) {
-		precount = m_prescale;
+	if (m_isr) {
+#if AVRTIMERS_TRACE
+		bool pending;
+		uint16_t start = read_counter(pending);
+		m_isr();
+		trace( AvrTrace::ISR, start );
+#else
+		m_isr();
+#endif
+	}
+	if (--m_precount == 0) {
+		m_precount = m_prescale;
 		AvrTimerBase::call_tasks();
 	}
-	
+	if (AVRTIMER2_NESTING != AVRTIMERS_NEST_NONE) 
+		sei();						// if call_tasks() didn't
+
 	if (m_async) {
 		while (ASSR & _BV(OCR2AUB)) {}
 	}
@@ -43,6 +43,10 @@
  volatile unsigned long timer0_millis = 0;
 
  unsigned long millis() {
+#if AVRTIMERS_TIMEBASE >= 0
+	AvrTimerBase* tb = AvrTimerBase::s_timers[AVRTIMERS_TIMEBASE];
+	if (tb) return tb->get_millis();
+#endif
 	unsigned long t;
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
 		t = timer0_millis;
@@ -53,67 +57,872 @@
 
 //---------------------------------------------------------------------------
 
-AvrTimerBase::AvrTimerBase(void) : m_millis(0), m_handle_millis(false)
+#if AVRTIMERS_PERSIST
+
+/// copy of m_millis that survives a reset, with check value
+typedef struct _persist_t {
+	uint32_t millis;
+#if AVRTIMERS_MILLIS64
+	uint16_t hi;		///< m_millis_hi
+	uint32_t check;		///< millis ^ hi ^ PERSIST_MAGIC
+#else
+	uint32_t check;		///< millis ^ PERSIST_MAGIC
+#endif
+} persist_t;
+
+#define PERSIST_MAGIC 0x5A3CC3A5uL
+
+#if AVRTIMERS_MILLIS64
+ #define PERSIST_CHECK(s)	((s)->millis ^ (s)->hi ^ PERSIST_MAGIC)
+#else
+ #define PERSIST_CHECK(s)	((s)->millis ^ PERSIST_MAGIC)
+#endif
+
+/// two alternating copies per timer, so one is always complete
+static persist_t s_persist[3][2] __attribute__((section(".noinit")));
+
+// set in .init3, before the startup code initializes .data and .bss
+uint8_t AvrTimerBase::s_reset_flags __attribute__((section(".noinit")));
+uint8_t AvrTimerBase::s_restored = 0;
+uint16_t AvrTimerBase::s_reset_ms = AVRTIMERS_RESET_MS;
+
+#ifdef __AVR__
+ #if !AVRTIMERS_WATCHDOG
+
+extern "C" void avrtimers_init3(void) __attribute__((naked, used, section(".init3")));
+
+/// save and clear MCUSR, so that the next reset shows only its own cause
+void avrtimers_init3(void)
+{
+	AvrTimerBase::s_reset_flags = MCUSR;
+	MCUSR = 0;
+}
+
+ #endif // !AVRTIMERS_WATCHDOG
+#else
+
+/// @brief do what the startup code does on the AVR: save and clear MCUSR.
+/// For the host simulation, call after avrsim::reset().
+void AvrTimerBase::save_reset_flags(void)
+{
+	s_reset_flags = MCUSR;
+	MCUSR = 0;
+	s_restored = 0;
+}
+
+#endif // __AVR__
+
+#endif // AVRTIMERS_PERSIST
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_JITTER
+uint16_t AvrTimerBase::s_rand = 0xACE1;
+#endif
+AvrTimerBase* AvrTimerBase::s_timers[3] = { NULL, NULL, NULL };
+uint8_t AvrTimerBase::s_clkps = 0;
+
+AvrTimerBase::AvrTimerBase(uint8_t id) : m_millis(0), m_id(id), 
+	m_FracAcc(0), m_trim(0), m_prescale(1), m_precount(1), m_handle_millis(false),
+#if AVRTIMERS_TIMEBASE >= 0
+	m_keep_millis(false),
+#endif
+	m_gated(false)
+{
+	if (id < 3) s_timers[id] = this;
+#if AVRTIMERS_NEST_MASKED
+	m_nest_masked = 0;
+#endif
+#if AVRTIMERS_MILLIS64
+	m_millis_hi = 0;
+	m_seq = 0;
+#endif
+#if AVRTIMERS_PERSIST
+#if AVRTIMERS_WATCHDOG && defined(__AVR__)
+	// MCUSR was already saved and cleared in .init3, by AvrWatchdog
+	s_reset_flags = AvrWatchdog::get_reset_flags();
+#endif
+	m_slot = 0;
+#endif
+#if AVRTIMERS_MAX_CLKPS
+	memset( m_clkcfg, 0, sizeof(m_clkcfg) );
+	m_reclock = NULL;
+#endif
+#if AVRTIMERS_IDLE_SCALING
+	m_rate_div = 1;
+	m_want_div = 1;
+	m_hold_rate = false;
+	m_cs0 = 0;
+	m_retune = NULL;
+#endif
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Calculate `num/den` as a 32-bit binary fraction, without 64-bit division
+ * @param num  numerator, must be less than `den`
+ * @param den  denominator, must be less than 2^31
+ * @return uint32_t  floor( 2^32 * num / den )
+ */
+static uint32_t ratio_q32( uint32_t num, uint32_t den )
+{
+	uint32_t q = 0;
+	for (uint8_t i=0; i<32; i++) {
+		num <<= 1;
+		q <<= 1;
+		if (num >= den) {
+			num -= den;
+			q |= 1;
+		}
+	}
+	return q;
+}
+
+
+/**
+ * @brief Calculate the millis and micros timebase for a timer configuration.
+ */
+void AvrTimerBase::calc_timebase(
+	timebase_t& tb,		///< [out] timebase parameters
+	uint32_t fclk,		///< timer clock [Hz], before the prescaler
+	uint16_t div,		///< prescaler, timer clocks per count
+	uint16_t period,	///< counts per interrupt (TOP+1)
+	uint8_t pre			///< interrupts per tick
+	)
+{
+	// microseconds per count, as 16.16 fixed point
+	uint32_t x = (uint32_t)div * 1000000uL;
+	tb.usPerCount = x / fclk;
+	tb.usPerCountFrac = ratio_q32( x % fclk, fclk ) >> 16;
+
+	// milliseconds per tick, as 32.32 fixed point: cycles * 1000 / fclk,
+	// one decimal digit at a time, so periods like 100 ms come out exact
+	uint32_t cycles = (uint32_t)div * period * pre;
+	uint32_t r = cycles % fclk;
+	uint32_t ms = cycles / fclk;
+	for (uint8_t i=0; i<3; i++) {
+		r *= 10;
+		ms = ms*10 + r / fclk;
+		r %= fclk;
+	}
+	tb.ms = ms;
+	tb.frac = ratio_q32( r, fclk );
+	tb.period = period;
+	tb.pre = pre;
+}
+
+
+/**
+ * @brief Set up the millis and micros timebase for the actual timer configuration.
+ * Typically called from init()
+ */
+void AvrTimerBase::set_timebase(const timebase_t& tb)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		m_usPerCount = tb.usPerCount;
+		m_usPerCountFrac = tb.usPerCountFrac;
+		m_period = tb.period;
+		if (m_prescale != tb.pre) {
+			m_prescale = tb.pre;
+			m_precount = tb.pre;
+		}
+		m_NomMillis = tb.ms;
+		m_NomFrac = tb.frac;
+		set_trim(m_trim);
+	}
+}
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_MAX_CLKPS
+
+/**
+ * @brief Change the system clock prescaler, and reprogram all active timers
+ * so that interrupt rates, PWM frequencies and millis stay correct.
+ * 
+ * The timer configurations for each prescaler value are precomputed in 
+ * begin(), so the switch itself only writes registers, with interrupts disabled.
+ * @param clkps  new value for CLKPR.CLKPS, CPU clock will be F_CPU >> clkps
+ * @return false if clkps is out of range, or an active timer can't achieve its rate
+ */
+bool AvrTimerBase::set_clock_prescaler(uint8_t clkps)
+{
+	if (clkps > AVRTIMERS_MAX_CLKPS) return false;
+	for (uint8_t i=0; i<3; i++) {
+		AvrTimerBase* t = s_timers[i];
+		if (t && t->m_reclock && t->m_clkcfg[0].cs && t->m_clkcfg[clkps].cs==0)
+			return false;
+	}
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		CLKPR = _BV(CLKPCE);
+		CLKPR = clkps;
+		s_clkps = clkps;
+		for (uint8_t i=0; i<3; i++) {
+			AvrTimerBase* t = s_timers[i];
+			// a timer switched off via PRR ignores register writes, power_on() reclocks it
+			if (t && t->m_reclock && t->m_clkcfg[0].cs && !t->m_gated)
+				t->apply_clkps(clkps);
+		}
+	}
+	return true;
+}
+
+
+/**
+ * @brief Reprogram this timer for system clock prescaler `clkps`. 
+ * Called with interrupts disabled.
+ */
+void AvrTimerBase::apply_clkps(uint8_t clkps)
 {
+	m_reclock(clkps);
+#if AVRTIMERS_IDLE_SCALING
+	// m_reclock() restored the nominal rate, lower it again
+	if (m_rate_div > 1 && !m_retune(m_rate_div, false))
+		set_rate_div(1, false);
+#endif
 }
 
+#endif // AVRTIMERS_MAX_CLKPS
+
 //---------------------------------------------------------------------------
 
-/// @brief	Register a callback function.
-void AvrTimerBase::add_task(
+/**
+ * @brief Steer the timebase by changing the effective tick period.
+ * Each tick advances `millis` by the nominal tick period plus `trim`.
+ * @param trim  correction [2^-32 ms per tick], positive makes the clock run faster
+ */
+void AvrTimerBase::set_trim(int32_t trim)
+{
+	uint32_t frac = m_NomFrac + (uint32_t)trim;
+	uint16_t ms = m_NomMillis;
+	if (trim >= 0) {
+		if (frac < m_NomFrac) ms++;		// carry
+	} else {
+		if (frac > m_NomFrac) ms--;		// borrow
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		m_trim = trim;
+		m_MillisPerTick = ms;
+		m_FracPerTick = frac;
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Step the timebase (and `millis()` if handled by this timer) by some microseconds.
+ * @param us  time step [us], positive moves the clock forward
+ */
+void AvrTimerBase::adjust_time(int32_t us)
+{
+	bool back = us < 0;
+	uint32_t mag = back ? -us : us;
+	uint32_t ms = mag / 1000uL;
+	uint32_t frac = (mag % 1000uL) * 4294967uL;	// 2^32 / 1000
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		uint32_t acc = m_FracAcc;
+		if (back) {
+			m_FracAcc = acc - frac;
+			if (m_FracAcc > acc) ms++;		// borrow
+#if AVRTIMERS_MILLIS64
+			if (m_millis < ms) m_millis_hi--;
+#endif
+			m_millis -= ms;
+			if (m_handle_millis) timer0_millis -= ms;
+		} else {
+			m_FracAcc = acc + frac;
+			if (m_FracAcc < acc) ms++;		// carry
+			m_millis += ms;
+#if AVRTIMERS_MILLIS64
+			if (m_millis < ms) m_millis_hi++;
+#endif
+			if (m_handle_millis) timer0_millis += ms;
+		}
+#if AVRTIMERS_MILLIS64
+		m_seq++;
+#endif
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief	Register a callback function.
+ * @return uint8_t  task number, for enable_task(), or NO_TASK if too many tasks
+ */
+uint8_t AvrTimerBase::add_task(
 	uint16_t scale,	///< call every `scale` interrupt cycle 
 	callback_t cb, ///< the callback function
 	void* arg		///<  generic pointer argument to be passed to callback function (e.g. instance pointer)
 	)
 {
 	if (m_nTasks < MAX_TIMER_TASKS) {
-		m_tasks[m_nTasks].count = 0;
-		m_tasks[m_nTasks].scale = scale;
-		m_tasks[m_nTasks].callback = cb;
-		m_tasks[m_nTasks].arg = arg;
-		m_nTasks++;
+		task_t* p = &m_tasks[m_nTasks];
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			p->count = 0;
+			p->period = scale;
+#if AVRTIMERS_IDLE_SCALING
+			p->scale = (scale >= m_rate_div) ? scale / m_rate_div : 1;
+#else
+			p->scale = scale;
+#endif
+			p->arg = arg;
+			p->flags = TASK_ENABLED;
+#if AVRTIMERS_JITTER
+			p->jitter = 0;
+#endif
+			p->callback = cb;
+			m_nTasks++;
+#if AVRTIMERS_IDLE_SCALING
+			rescale_idle();
+#endif
+		}
+		return m_nTasks-1;
 	} else {
 #if DEBUG_AVRTIMERS
 		DEBUG_PRINT( "Too many timer tasks!\r\n" );
 #endif
+		return NO_TASK;
 	}
 }
 
 //---------------------------------------------------------------------------
 
-/// @brief	Update `millis` etc counters, and call all registered callback functions.
-void AvrTimerBase::call_tasks(void)
+/**
+ * @brief	Enable or disable a callback function.
+ * With AVRTIMERS_IDLE_SCALING, the interrupt rate is adjusted to the enabled tasks.
+ */
+void AvrTimerBase::enable_task(
+	uint8_t task,	///< task number, as returned by add_task()
+	bool enable		///< true to enable, false to disable
+	)
+{
+	if (task >= m_nTasks) return;
+	task_t* p = &m_tasks[task];
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (enable) 
+			p->flags |= TASK_ENABLED;
+		else
+			p->flags &= ~(TASK_ENABLED | TASK_PENDING);
+#if AVRTIMERS_IDLE_SCALING
+		rescale_idle();
+#endif
+	}
+}
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_PRIORITIES
+
+/**
+ * @brief	Set the priority of a callback function.
+ * `HighPriority` tasks run first, with interrupts disabled, so keep them short.
+ * `NormalPriority` tasks run after interrupts are enabled, and can be interrupted.
+ * `DeferredPriority` tasks only become due in the ISR, and run from run_deferred().
+ */
+void AvrTimerBase::set_priority(
+	uint8_t task,	///< task number, as returned by add_task()
+	Priority prio	///< new priority
+	)
+{
+	if (task >= m_nTasks) return;
+	task_t* p = &m_tasks[task];
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		p->flags = (p->flags & ~(TASK_HIGH | TASK_DEFERRED | TASK_PENDING)) | prio;
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief	Call the deferred tasks that have become due. Call this from the main loop.
+ * Ticks that pass before the task runs are coalesced into one call.
+ * @return true if any task ran
+ */
+bool AvrTimerBase::run_deferred(void)
+{
+	bool ran = false;
+	uint8_t i; task_t* p;
+	for (i=0, p=m_tasks; i<m_nTasks; i++, p++) {
+		uint8_t flags;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			flags = p->flags;
+			p->flags = flags & ~TASK_PENDING;
+		}
+		if (flags & TASK_PENDING) {
+			(p->callback)(p->arg);
+			ran = true;
+		}
+	}
+	return ran;
+}
+
+#endif // AVRTIMERS_PRIORITIES
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_JITTER
+
+/**
+ * @brief	Let the period of a task vary randomly between `period-jitter` and 
+ * `period+jitter` ticks, e.g. so that nodes that start at the same time 
+ * don't keep transmitting at the same time. The average period stays `period`.
+ * Each period is drawn in the ISR, with a 16-bit xorshift generator; seed it 
+ * differently on each device with seed_jitter(). `jitter` is limited so that
+ * periods stay between 1 and 65535 ticks, and to 32767.
+ */
+void AvrTimerBase::set_jitter(
+	uint8_t task,		///< task number, as returned by add_task()
+	uint16_t jitter,	///< max. deviation [ticks], less than the period, 0 for none
+	Jitter dist			///< `JitterUniform`, or `JitterTriangular` for deviations near 0 more likely
+	)
+{
+	if (task >= m_nTasks) return;
+	task_t* p = &m_tasks[task];
+	// keep period-jitter >= 1, period+jitter and 2*jitter+1 within 16 bits
+	if (jitter >= p->period) jitter = p->period - 1;
+	if (jitter > UINT16_MAX - p->period) jitter = UINT16_MAX - p->period;
+	if (jitter > INT16_MAX) jitter = INT16_MAX;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		p->jitter = jitter;
+		p->flags = (p->flags & ~TASK_TRIANGULAR) | dist;
+		if (jitter) {
+			draw_period(p);
+		} else {
+#if AVRTIMERS_IDLE_SCALING
+			p->scale = (p->period >= m_rate_div) ? p->period / m_rate_div : 1;
+#else
+			p->scale = p->period;
+#endif
+		}
+#if AVRTIMERS_IDLE_SCALING
+		rescale_idle();
+#endif
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief draw the length of the next period of task `p`, which has jitter
+void AvrTimerBase::draw_period(task_t* p)
+{
+	uint16_t j = p->jitter;
+	uint16_t offset;
+	if (p->flags & TASK_TRIANGULAR) 
+		offset = rand_below(j+1) + rand_below(j+1);
+	else
+		offset = rand_below(2*j+1);
+	p->scale = p->period - j + offset;
+}
+
+#endif // AVRTIMERS_JITTER
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_IDLE_SCALING
+
+static uint16_t gcd( uint16_t a, uint16_t b )
 {
-	static uint8_t subms = 0;
+	while (b) {
+		uint16_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
 
-	if (m_handle_millis) {
-		timer0_millis += m_MillisPerTick;
+/**
+ * @brief Change the interrupt rate to nominal rate / `div`, and rescale task counters.
+ * Called with interrupts disabled, or from apply_rate_div().
+ * @param at_tick  true if called right after a tick, see m_retune
+ * @return false if the timer can't be set to that rate
+ */
+bool AvrTimerBase::set_rate_div(uint16_t div, bool at_tick)
+{
+	bool ok = false;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (m_retune(div, at_tick)) {
+			uint8_t i; task_t* p;
+			for (i=0, p=m_tasks; i<m_nTasks; i++, p++) {
+				// a disabled task may have a period shorter than the lowered tick
+				p->scale = (p->period >= div) ? p->period / div : 1;
+				p->count = ((uint32_t)p->count * m_rate_div) / div;
+			}
+			m_rate_div = div;
+			ok = true;
+		}
 	}
-	if (m_MillisPerTick) {
-		m_millis += m_MillisPerTick;
+	return ok;
+}
+
+
+/**
+ * @brief Request the interrupt rate for the GCD of the periods of all enabled 
+ * tasks, or the nominal rate if a fast task has been enabled, or PWM or a 
+ * per-interrupt function needs it. The ISR switches at the next tick, so that
+ * no time is lost. Called with interrupts disabled.
+ */
+void AvrTimerBase::rescale_idle(void)
+{
+	if (!m_retune || !m_cs0) return;	// not initialized yet
+
+	uint16_t div = 0;
+	if (m_hold_rate) {
+		div = 1;
 	} else {
-		if (++subms >= m_TicksPerMilli) {
-			subms = 0;
-			m_millis++;
+		uint8_t i; task_t* p;
+		for (i=0, p=m_tasks; i<m_nTasks; i++, p++) {
+			if (p->callback && (p->flags & TASK_ENABLED))
+#if AVRTIMERS_JITTER
+				div = gcd( div, p->jitter ? 1 : p->period );	// random periods need every tick
+#else
+				div = gcd( div, p->period );
+#endif
+		}
+	}
+	if (div == 0) return;	// no tasks enabled, keep rate
+	m_want_div = div;
+}
+
+
+/**
+ * @brief Switch to the rate requested by rescale_idle(), or the next lower 
+ * rate that the timer can generate. Called from the ISR, right after a tick.
+ * A lower rate is only applied at a tick where all enabled tasks are due at 
+ * the lowered ticks, so that none of them is delayed.
+ */
+void AvrTimerBase::apply_rate_div(void)
+{
+	uint16_t div = m_want_div;
+	if (div > m_rate_div) {
+		// tasks with different phases can only share ticks at a common divisor 
+		uint16_t e0 = 0;
+		bool first = true;
+		uint8_t i; task_t* p;
+		for (i=0, p=m_tasks; i<m_nTasks; i++, p++) {
+			if (!p->callback || !(p->flags & TASK_ENABLED)) continue;
+			uint16_t e = p->count * m_rate_div;		// nominal ticks since the last call
+			if (first) 
+				e0 = e;
+			else
+				div = gcd( div, (e > e0) ? e - e0 : e0 - e );
+			first = false;
+		}
+		if (div <= m_rate_div) {
+			m_want_div = m_rate_div;	// phases don't allow a lower rate
+			return;
+		}
+		if (e0 % div) return;			// try again at the next tick
+	}
+	while (div > 1) {
+		if (div == m_rate_div || set_rate_div(div, true)) break;
+		// rate not achievable, try next smaller divisor
+		uint16_t d = 2;
+		while (div % d) d++;
+		div /= d;
+	}
+	if (div == 1 && m_rate_div != 1) set_rate_div(1, true);
+	m_want_div = m_rate_div;		// don't try again at every tick
+}
+
+
+/**
+ * @brief Keep the nominal interrupt rate while `hold` is true, e.g. while PWM
+ * is active. The rate changes at the next tick.
+ */
+void AvrTimerBase::hold_rate(bool hold)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		m_hold_rate = hold;
+		rescale_idle();
+	}
+}
+
+
+/**
+ * @brief The timer has been initialized at its nominal rate: reset the task
+ * scales, and request the lowered rate again. Called from init().
+ */
+void AvrTimerBase::reset_rate_div(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		uint8_t i; task_t* p;
+		for (i=0, p=m_tasks; i<m_nTasks; i++, p++) {
+			p->count = 0;
+			p->scale = p->period;
 		}
+		m_rate_div = 1;
+		m_want_div = 1;
+		rescale_idle();
+	}
+}
+
+#endif // AVRTIMERS_IDLE_SCALING
+
+//---------------------------------------------------------------------------
+
+/** 
+ * @brief	Update `millis` etc counters, and call all registered callback functions.
+ * This is called with interrupts disabled, and enables them after updating 
+ * the time (and, with AVRTIMERS_PRIORITIES, after the high priority tasks), 
+ * unless the timer's nesting policy is AVRTIMERS_NEST_NONE. So an interrupt
+ * that nests in the tasks, e.g. a PPS edge, sees the time of this tick.
+ */
+void AvrTimerBase::call_tasks(void)
+{
+#if AVRTIMERS_TRACE
+	bool pending;
+	uint16_t tick_start = read_counter(pending);
+#endif
+#if AVRTIMERS_TIMEBASE >= 0
+	if (keeps_time())		// other timers leave timekeeping to the timebase
+#endif
+	{
+		uint32_t acc = m_FracAcc + m_FracPerTick;
+		uint16_t ms = m_MillisPerTick;
+		if (acc < m_FracAcc) ms++;		// carry from fractional milliseconds
+		m_FracAcc = acc;
+
+		if (m_handle_millis) {
+			timer0_millis += ms;
+		}
+		uint32_t t = m_millis + ms;
+#if AVRTIMERS_MILLIS64
+		if (t < ms) m_millis_hi++;		// carry only when m_millis wraps
+		m_millis = t;
+		m_seq++;
+#else
+		m_millis = t;
+#endif
+#if AVRTIMERS_PERSIST
+		m_slot ^= 1;
+		persist_t* s = &s_persist[m_id][m_slot];
+		s->millis = t;
+ #if AVRTIMERS_MILLIS64
+		s->hi = m_millis_hi;
+ #endif
+		s->check = PERSIST_CHECK(s);
+#endif
 	}
 		
 	uint8_t i; task_t* p;
+#if AVRTIMERS_PRIORITIES
+	for (i=0, p=m_tasks; i<m_nTasks; i++, p++) {
+		if ((p->flags & (TASK_ENABLED|TASK_HIGH)) != (TASK_ENABLED|TASK_HIGH)) continue;
+		if (++(p->count) >= (p->scale)) {
+ #if AVRTIMERS_TRACE
+			uint16_t start = read_counter(pending);
+			(p->callback)(p->arg);
+			trace( i, start );
+ #else
+			(p->callback)(p->arg);
+ #endif
+			restart(p);
+		}
+	}
+#endif
+	if (nests()) sei();
 	for (i=0, p=m_tasks; i<m_nTasks; i++, p++) {
 		if (p->callback) {
+			if (!(p->flags & TASK_ENABLED)) continue;
+#if AVRTIMERS_PRIORITIES
+			if (p->flags & TASK_HIGH) continue;
+			if (p->flags & TASK_DEFERRED) {
+				if (++(p->count) >= (p->scale)) {
+					p->flags |= TASK_PENDING;
+					restart(p);
+				}
+				continue;
+			}
+#endif
 			if (++(p->count) >= (p->scale)) {
+#if AVRTIMERS_TRACE
+				uint16_t start = read_counter(pending);
+				(p->callback)(p->arg);
+				trace( i, start );
+#else
 				(p->callback)(p->arg);
-				p->count = 0;
+#endif
+				restart(p);
 			}
 		} else break;
 	}
+#if AVRTIMERS_TRACE
+	trace( AvrTrace::TICK, tick_start );
+#endif
+#if AVRTIMERS_IDLE_SCALING
+	if (m_want_div != m_rate_div) apply_rate_div();
+#endif
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief	Return true if any enabled task, or the `millis()` counter, depends on this timer.
+bool AvrTimerBase::has_tasks(void)
+{
+	if (m_handle_millis) return true;
+#if AVRTIMERS_TIMEBASE >= 0
+	if (m_id == AVRTIMERS_TIMEBASE) return true;	// all time queries depend on it
+#endif
+	uint8_t i; task_t* p;
+	for (i=0, p=m_tasks; i<m_nTasks; i++, p++) {
+		if (p->callback && (p->flags & TASK_ENABLED)) return true;
+	}
+	return false;
 }
 
 //---------------------------------------------------------------------------
 
-/// @brief	Return milliseconds since start of timer.
+/**
+ * @brief Stop the timer clock and switch the timer off via the power reduction register.
+ * The timer registers are frozen, and restored by power_on(). Typically called from stop().
+ */
+void AvrTimerBase::power_off(void)
+{
+	if (m_gated) return;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		switch (m_id) {
+			case 0:
+				m_tccrb = TCCR0B;
+				TCCR0B = m_tccrb & ~(7 << CS00);
+				PRR |= _BV(PRTIM0);
+				break;
+			case 1:
+				m_tccrb = TCCR1B;
+				TCCR1B = m_tccrb & ~(7 << CS10);
+				PRR |= _BV(PRTIM1);
+				break;
+			case 2:
+				m_tccrb = TCCR2B;
+				TCCR2B = m_tccrb & ~(7 << CS20);
+				if (ASSR & _BV(AS2))
+					while (ASSR & _BV(TCR2BUB)) {}
+				PRR |= _BV(PRTIM2);
+				break;
+			default:
+				return;
+		}
+		m_gated = true;
+#if AVRTIMERS_MAX_CLKPS
+		m_gated_clkps = s_clkps;
+#endif
+	}
+}
+
+
+/**
+ * @brief Switch the timer on again after power_off(), and restore its clock.
+ * Typically called from start().
+ */
+void AvrTimerBase::power_on(void)
+{
+	if (!m_gated) return;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		switch (m_id) {
+			case 0:
+				PRR &= ~_BV(PRTIM0);
+				TCCR0B = m_tccrb;
+				break;
+			case 1:
+				PRR &= ~_BV(PRTIM1);
+				TCCR1B = m_tccrb;
+				break;
+			case 2:
+				PRR &= ~_BV(PRTIM2);
+				TCCR2B = m_tccrb;
+				if (ASSR & _BV(AS2))
+					while (ASSR & _BV(TCR2BUB)) {}
+				break;
+		}
+		m_gated = false;
+#if AVRTIMERS_MAX_CLKPS
+		// set_clock_prescaler() skipped the timer while it was off
+		if (m_gated_clkps != s_clkps && m_reclock && m_clkcfg[0].cs)
+			apply_clkps(s_clkps);
+#endif
+	}
+}
+
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_PERSIST
+
+/**
+ * @brief Restore millis from the `.noinit` copy after a watchdog, brown-out or 
+ * external reset, plus the estimated reset duration. Typically called from init().
+ * Nothing happens after a power-on reset, or if the copy is corrupt.
+ * Call handle_millis() before begin() to also restore the `millis()` counter.
+ */
+void AvrTimerBase::restore_millis(void)
+{
+	if (m_id >= 3 || (s_restored & _BV(m_id))) return;
+	s_restored |= _BV(m_id);
+
+	if (s_reset_flags & _BV(PORF)) return;
+	if (!(s_reset_flags & (_BV(WDRF)|_BV(BORF)|_BV(EXTRF)))) return;
+
+	bool found = false;
+	uint32_t t = 0;
+#if AVRTIMERS_MILLIS64
+	uint16_t hi = 0;
+#endif
+	for (uint8_t i=0; i<2; i++) {
+		const persist_t* s = &s_persist[m_id][i];
+		if (PERSIST_CHECK(s) != s->check) continue;
+		if (!found || (int32_t)(s->millis - t) > 0) {
+			t = s->millis;
+#if AVRTIMERS_MILLIS64
+			hi = s->hi;
+#endif
+			found = true;
+		}
+	}
+	if (!found) return;
+	t += s_reset_ms;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		m_millis = t;
+#if AVRTIMERS_MILLIS64
+		if (t < s_reset_ms) hi++;
+		m_millis_hi = hi;
+		m_seq++;
+#endif
+		if (m_handle_millis) timer0_millis = t;
+	}
+#if DEBUG_AVRTIMERS
+	DEBUG_PRINTF(" T%u: restored %lu ms\r\n", m_id, t );
+#endif
+}
+
+#endif // AVRTIMERS_PERSIST
+
+//---------------------------------------------------------------------------
+
+/// @brief	Return milliseconds since start of timer, or of the timebase, see AVRTIMERS_TIMEBASE.
 uint32_t AvrTimerBase::get_millis()
 {
+#if AVRTIMERS_TIMEBASE >= 0
+	if (clock() != this) return clock()->get_millis();
+#endif
 	uint32_t temp;
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
@@ -122,4 +931,133 @@ uint32_t AvrTimerBase::get_millis()
 	return temp;
 }
 
+//---------------------------------------------------------------------------
+
+#if AVRTIMERS_MILLIS64
+
+/** 
+ * @brief Read m_millis and its carries consistently, without disabling interrupts:
+ * read again if a tick happened in between. For use outside of timer ISRs.
+ */
+void AvrTimerBase::read_millis64(uint16_t& hi, uint32_t& lo)
+{
+#if AVRTIMERS_TIMEBASE >= 0
+	if (clock() != this) { clock()->read_millis64( hi, lo ); return; }
+#endif
+	uint8_t seq;
+	do {
+		seq = m_seq;
+		hi = m_millis_hi;
+		lo = m_millis;
+	} while (seq != m_seq);
+}
+
+
+/// @brief	Return milliseconds since start of timer, in 48 bits (8900 years).
+uint64_t AvrTimerBase::get_millis64()
+{
+	uint16_t hi;
+	uint32_t lo;
+	read_millis64( hi, lo );
+	return ((uint64_t)hi << 32) | lo;
+}
+
+
+/// @brief	Return seconds since start of timer, wraps around after 136 years.
+uint32_t AvrTimerBase::get_seconds()
+{
+	uint16_t hi;
+	uint32_t lo;
+	read_millis64( hi, lo );
+	// 2^32 ms = 4294967 s + 296 ms, so no 64-bit division is needed
+	return hi * 4294967uL + lo / 1000uL + ((lo % 1000uL) + hi * 296uL) / 1000uL;
+}
+
+#endif // AVRTIMERS_MILLIS64
+
+//---------------------------------------------------------------------------
+
+/// @brief	Convert timer counts to microseconds.
+uint32_t AvrTimerBase::counts_to_us(uint32_t counts)
+{
+	uint32_t us = counts * m_usPerCount;
+	// counts * m_usPerCountFrac would overflow for more than 2^16 counts
+	if (counts >> 16) {
+		us += (counts >> 16) * m_usPerCountFrac;
+		counts &= 0xFFFF;
+	}
+	return us + ((counts * m_usPerCountFrac) >> 16);
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Read the hardware counter of this timer.
+ * The counter is read before the interrupt flag, like Arduino micros() does:
+ * if the timer wraps in between, the flag is set and the count is small.
+ * Read the other way round, the flag could be clear and the count small, 
+ * and the interrupt would be missed.
+ * @param pending  set to true if the timer interrupt is pending
+ * @return uint16_t  value of TCNTn
+ */
+uint16_t AvrTimerBase::read_counter(bool& pending)
+{
+	uint16_t counts;
+
+	switch (m_id) {
+		case 0:
+#if AVRTIMER0_SHARED
+			// counting from the compare match B, not from BOTTOM
+			counts = (uint8_t)(TCNT0 - OCR0B - 1);
+			pending = TIFR0 & _BV(OCF0B);
+#else
+			counts = TCNT0;
+			pending = TIFR0 & _BV(OCF0A);
+#endif
+			return counts;
+		case 1:
+			counts = TCNT1;
+			pending = TIFR1 & _BV(TOV1);
+			return counts;
+		case 2:
+			counts = TCNT2;
+			pending = TIFR2 & _BV(OCF2A);
+			return counts;
+		default:
+			pending = false;
+			return 0;
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief	Return microseconds since start of timer.
+ * Resolution is one count of the timer, i.e. the prescaled timer clock. 
+ * Like Arduino micros(), the result wraps around after about 71 minutes.
+ */
+uint32_t AvrTimerBase::get_micros()
+{
+#if AVRTIMERS_TIMEBASE >= 0
+	if (clock() != this) return clock()->get_micros();
+#endif
+	uint32_t ms, frac;
+	uint32_t counts;			// up to m_prescale periods of up to 65535 counts
+	bool pending;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		ms = m_millis;
+		frac = m_FracAcc;
+		counts = read_counter(pending);
+		// interrupts since last tick, plus one if the interrupt is waiting
+		uint8_t ints = m_prescale - m_precount;
+		if (pending && counts < (m_period >> 1)) ints++;
+		counts += (uint32_t)ints * m_period;
+	}
+	return ms * 1000uL 
+		+ (((frac >> 16) * 1000uL) >> 16) 
+		+ counts_to_us(counts);
+}
+
 /** @} */
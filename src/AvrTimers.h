@@ -39,7 +39,8 @@
 
  All timers support
  - regular interrupts, with the rate specified in Hz
- - maintaining a milliceconds counter, similar to Arduino millis()
+ - maintaining a milliceconds counter, similar to Arduino millis(), and a
+   microseconds counter with the resolution of the timer clock
  - calling multiple event handler functions for every interrupt or every N interrupts
 
  Timer0 also supports
@@ -67,6 +68,166 @@
  #define DEBUG_AVRTIMERS 0
 #endif 
 
+// max. system clock prescaler (CLKPR.CLKPS) supported by set_clock_prescaler(), 0 to disable
+#ifndef AVRTIMERS_MAX_CLKPS
+ #define AVRTIMERS_MAX_CLKPS 0
+#endif
+
+// if this is defined !=0, the interrupt rate is lowered while only slow tasks are enabled
+#ifndef AVRTIMERS_IDLE_SCALING
+ #define AVRTIMERS_IDLE_SCALING 0
+#endif
+
+// if this is defined !=0, millis survive watchdog, brown-out and external resets
+#ifndef AVRTIMERS_PERSIST
+ #define AVRTIMERS_PERSIST 0
+#endif
+
+// estimated duration of a reset, added to the restored millis [ms]
+#ifndef AVRTIMERS_RESET_MS
+ #define AVRTIMERS_RESET_MS 0
+#endif
+
+// if this is defined !=0, timers record events into a trace buffer of that size (power of 2)
+#ifndef AVRTIMERS_TRACE
+ #define AVRTIMERS_TRACE 0
+#endif
+
+#if AVRTIMERS_TRACE
+ #include "AvrTrace.h"
+#endif
+
+// if this is defined !=0, a timer interrupt samples the program counter into that many buckets
+#ifndef AVRTIMERS_PROFILE
+ #define AVRTIMERS_PROFILE 0
+#endif
+
+// timer (0, 1 or 2) whose interrupt takes the profiler samples
+#ifndef AVRTIMERS_PROFILE_TIMER
+ #define AVRTIMERS_PROFILE_TIMER 2
+#endif
+
+// if this is defined !=0, monitor stack usage and nesting of the timer ISRs
+#ifndef AVRTIMERS_STACK_MONITOR
+ #define AVRTIMERS_STACK_MONITOR 0
+#endif
+
+#if AVRTIMERS_STACK_MONITOR
+ #include "AvrStackMonitor.h"
+ #define AVRTIMERS_ISR_ENTER()	AvrStackMonitor::isr_enter()
+ #define AVRTIMERS_ISR_EXIT()	AvrStackMonitor::isr_exit()
+#else
+ #define AVRTIMERS_ISR_ENTER()
+ #define AVRTIMERS_ISR_EXIT()
+#endif
+
+// if this is defined !=0, a software watchdog supervises up to that many tasks or main loop sections
+#ifndef AVRTIMERS_WATCHDOG
+ #define AVRTIMERS_WATCHDOG 0
+#endif
+
+#if AVRTIMERS_WATCHDOG
+ #include "AvrWatchdog.h"
+#endif
+
+// if this is defined !=0, up to that many deferred handlers wait on event flags set by ISRs
+#ifndef AVRTIMERS_EVENTS
+ #define AVRTIMERS_EVENTS 0
+#endif
+
+#if AVRTIMERS_EVENTS
+ #include "AvrEvents.h"
+#endif
+
+// if this is defined !=0, tasks can run with interrupts disabled, or deferred to the main loop
+#ifndef AVRTIMERS_PRIORITIES
+ #define AVRTIMERS_PRIORITIES 0
+#endif
+
+// if this is defined !=0, task periods can vary randomly around their nominal value
+#ifndef AVRTIMERS_JITTER
+ #define AVRTIMERS_JITTER 0
+#endif
+
+// call_tasks() enables interrupts after updating millis (and after the high priority tasks),
+// so an interrupt that nests in the ISR already sees the new time
+#define AVRTIMERS_ISR_SEI()
+
+// ISR nesting policy, per timer AVRTIMERn_NESTING
+#define AVRTIMERS_NEST_NONE		0	// tasks run with interrupts disabled
+#define AVRTIMERS_NEST_ALL		1	// tasks can be interrupted by any interrupt, even the own timer's
+#define AVRTIMERS_NEST_OTHERS	2	// tasks can be interrupted by any interrupt but the own timer's
+
+#ifndef AVRTIMER0_NESTING
+ #define AVRTIMER0_NESTING AVRTIMERS_NEST_ALL
+#endif
+#ifndef AVRTIMER1_NESTING
+ #define AVRTIMER1_NESTING AVRTIMERS_NEST_ALL
+#endif
+#ifndef AVRTIMER2_NESTING
+ #define AVRTIMER2_NESTING AVRTIMERS_NEST_ALL
+#endif
+
+#define AVRTIMERS_NEST_MASKED	(AVRTIMER0_NESTING==AVRTIMERS_NEST_OTHERS \
+	|| AVRTIMER1_NESTING==AVRTIMERS_NEST_OTHERS || AVRTIMER2_NESTING==AVRTIMERS_NEST_OTHERS)
+
+/// ISR entry, after time-critical work: apply nesting `policy` (0, 1 or 2) of a timer, whose interrupt is enabled by `bit` in `timsk`
+#define AVRTIMERS_NEST_BEGIN(policy, inst, timsk, bit)	AVRTIMERS_NEST_BEGIN_(policy, inst, timsk, bit)
+/// ISR exit: enable the own timer's interrupt again, unless stop() was called meanwhile
+#define AVRTIMERS_NEST_END(policy, inst, timsk, bit)	AVRTIMERS_NEST_END_(policy, inst, timsk, bit)
+
+// one expansion per policy, so each ISR only contains the code for its own policy
+#define AVRTIMERS_NEST_BEGIN_(policy, inst, timsk, bit)	AVRTIMERS_NEST_BEGIN_##policy(inst, timsk, bit)
+#define AVRTIMERS_NEST_END_(policy, inst, timsk, bit)	AVRTIMERS_NEST_END_##policy(inst, timsk, bit)
+#define AVRTIMERS_NEST_BEGIN_0(inst, timsk, bit)
+#define AVRTIMERS_NEST_END_0(inst, timsk, bit)
+#define AVRTIMERS_NEST_BEGIN_1(inst, timsk, bit)	AVRTIMERS_ISR_SEI()
+#define AVRTIMERS_NEST_END_1(inst, timsk, bit)
+#define AVRTIMERS_NEST_BEGIN_2(inst, timsk, bit)	do { \
+		timsk &= ~_BV(bit); (inst)->m_nest_masked = _BV(bit); AVRTIMERS_ISR_SEI(); } while (0)
+#define AVRTIMERS_NEST_END_2(inst, timsk, bit)		do { \
+		cli(); timsk |= (inst)->m_nest_masked; (inst)->m_nest_masked = 0; } while (0)
+
+// if this is defined as 0, 1 or 2, only that timer keeps time, and all time queries use it
+#ifndef AVRTIMERS_TIMEBASE
+ #define AVRTIMERS_TIMEBASE -1
+#endif
+
+// if this is defined !=0, timers also count millis in 48 bits, and seconds, which don't wrap around
+#ifndef AVRTIMERS_MILLIS64
+ #define AVRTIMERS_MILLIS64 0
+#endif
+
+// if this is defined !=0, Timer1 counts CPU cycles in 32 bits, for AvrStopwatch
+#ifndef AVRTIMERS_STOPWATCH
+ #define AVRTIMERS_STOPWATCH 0
+#endif
+
+// if this is defined !=0, Timer0 keeps the Arduino core's configuration, and runs tasks from compare match B
+#ifndef AVRTIMER0_SHARED
+ #define AVRTIMER0_SHARED 0
+#endif
+
+#if AVRTIMER0_SHARED
+ #define AVRTIMER0_vect TIMER0_COMPB_vect
+ #define AVRTIMER0_IE	OCIE0B
+#else
+ #define AVRTIMER0_vect TIMER0_COMPA_vect
+ #define AVRTIMER0_IE	OCIE0A
+#endif
+
+#if AVRTIMERS_PROFILE
+ #include "AvrProfiler.h"
+ // the profiler provides the ISR of that timer
+ #if AVRTIMERS_PROFILE_TIMER==0
+  #define AVRTIMER0_CUSTOM_ISR
+ #elif AVRTIMERS_PROFILE_TIMER==1
+  #define AVRTIMER1_CUSTOM_ISR
+ #else
+  #define AVRTIMER2_CUSTOM_ISR
+ #endif
+#endif
+
 #ifndef ARDUINO
  unsigned long millis();
 #endif
@@ -86,28 +247,224 @@ public:
 	/// parameters that define a callback task.
 	typedef struct _task_t {
 		callback_t callback;
-		uint16_t scale;
+		uint16_t scale;		///< call every `scale` interrupt ticks
 		uint16_t count;
 		void*	arg;
+		uint16_t period;	///< call every `period` ticks at the nominal rate
+		uint8_t  flags;
+#if AVRTIMERS_JITTER
+		uint16_t jitter;	///< max. random deviation from `period` [ticks]
+#endif
 	} task_t;
 	static const int MAX_TIMER_TASKS = 4;
+	/// task_t.flags: task is enabled
+	static const uint8_t TASK_ENABLED = 0x01;
+	/// task_t.flags: task runs before interrupts are enabled
+	static const uint8_t TASK_HIGH = 0x02;
+	/// task_t.flags: task runs from run_deferred()
+	static const uint8_t TASK_DEFERRED = 0x04;
+	/// task_t.flags: deferred task is due
+	static const uint8_t TASK_PENDING = 0x08;
+	/// task_t.flags: jitter has a triangular distribution
+	static const uint8_t TASK_TRIANGULAR = 0x10;
+	/// task priority, see set_priority()
+	enum Priority { HighPriority=TASK_HIGH, NormalPriority=0, DeferredPriority=TASK_DEFERRED };
+	/// distribution of the task period jitter, see set_jitter()
+	enum Jitter { JitterUniform=0, JitterTriangular=TASK_TRIANGULAR };
+	/// returned by add_task() if there is no room for another task
+	static const uint8_t NO_TASK = 0xFF;
+	/// parameters of the millis and micros timebase, for one timer configuration
+	typedef struct _timebase_t {
+		uint32_t frac;				///< tick period, fractional part [2^-32 ms]
+		uint16_t ms;				///< tick period, integer part [ms]
+		uint16_t usPerCount;		///< counter period, integer part [us]
+		uint16_t usPerCountFrac;	///< counter period, fractional part [2^-16 us]
+		uint16_t period;			///< counts per interrupt (TOP+1)
+		uint8_t  pre;				///< interrupts per tick
+	} timebase_t;
+	/// timer configuration for one system clock prescaler setting
+	typedef struct _clkcfg_t {
+		uint8_t  cs;				///< clock select, 0 if rate can't be achieved
+		uint16_t ocr;				///< counts per interrupt
+		timebase_t tb;
+	} clkcfg_t;
 	// pointer to singleton instance, used by ISR
 	//static AvrTimerBase* theInstance;
+	/// all timer instances, indexed by timer number
+	static AvrTimerBase* s_timers[3];
+	/// current system clock prescaler CLKPR.CLKPS, CPU clock is F_CPU >> s_clkps
+	static uint8_t s_clkps;
+#if AVRTIMERS_NEST_MASKED
+	/// own interrupt enable bit, masked by the ISR while tasks run (AVRTIMERS_NEST_OTHERS)
+	volatile uint8_t m_nest_masked;
+#endif
 
-	AvrTimerBase(void);
+	AvrTimerBase(uint8_t id);
+#if AVRTIMERS_PERSIST
+	/// MCUSR at startup, decides if millis are restored in begin()
+	static uint8_t s_reset_flags;
+	/// timers whose millis have been restored since the reset, one bit per timer
+	static uint8_t s_restored;
+	/// estimated duration of a reset [ms], added to the restored millis
+	static uint16_t s_reset_ms;
+	/// @brief override reset flags, e.g. if a bootloader has already cleared MCUSR
+	static void set_reset_flags(uint8_t flags) { s_reset_flags = flags; }
+	/// @brief set the estimated duration of a reset [ms]
+	static void set_reset_ms(uint16_t ms) { s_reset_ms = ms; }
+ #ifndef __AVR__
+	/// @brief host simulation only: save and clear MCUSR after avrsim::reset()
+	static void save_reset_flags(void);
+ #endif
+#endif
+#if AVRTIMERS_MAX_CLKPS
+	static bool set_clock_prescaler(uint8_t clkps);
+#endif
 
 	uint32_t get_millis();
-	uint8_t get_millis_per_tick()  { return m_MillisPerTick; }
-	void add_task(uint16_t scale, callback_t cb, void* arg=NULL);
+	uint32_t get_micros();
+#if AVRTIMERS_MILLIS64
+	uint64_t get_millis64();
+	uint32_t get_seconds();
+#endif
+	uint16_t get_millis_per_tick()  { return m_MillisPerTick; }
+	uint8_t add_task(uint16_t scale, callback_t cb, void* arg=NULL);
+	void enable_task(uint8_t task, bool enable=true);
+	void disable_task(uint8_t task) { enable_task(task,false); }
+#if AVRTIMERS_PRIORITIES
+	void set_priority(uint8_t task, Priority prio);
+	bool run_deferred(void);
+#endif
+#if AVRTIMERS_JITTER
+	void set_jitter(uint8_t task, uint16_t jitter, Jitter dist=JitterUniform);
+	/// @brief seed the jitter generator, with something unique per device, e.g. a node address
+	static void seed_jitter(uint16_t seed) { s_rand = seed ? seed : 1; }
+#endif
 	void call_tasks(void);
 	void handle_millis() { m_handle_millis=true; }
+#if AVRTIMERS_TIMEBASE >= 0
+	/// @brief keep a time of this timer's own, although it is not the timebase
+	void keep_millis() { m_keep_millis=true; }
+#endif
+
+	void set_trim(int32_t trim);
+	/// @brief current trim of the tick period, in 2^-32 ms per tick
+	int32_t get_trim() { return m_trim; }
+	/// @brief nominal tick period [ms]
+	float get_tick_ms() { return m_NomMillis + m_NomFrac * (1.0f/4294967296.0f); }
+	void adjust_time(int32_t us);
 protected:
 	volatile uint32_t m_millis;		
+#if AVRTIMERS_MILLIS64
+	volatile uint16_t m_millis_hi;	///< carries out of m_millis
+	volatile uint8_t  m_seq;		///< incremented after every change of m_millis
+	void read_millis64(uint16_t& hi, uint32_t& lo);
+#endif
 	task_t      m_tasks[MAX_TIMER_TASKS];
 	uint8_t     m_nTasks;
-	uint8_t     m_MillisPerTick;
-	uint8_t     m_TicksPerMilli;
+	uint8_t     m_id;				///< timer number, selects TCNTn and TIFRn
+	uint16_t    m_MillisPerTick;	///< integer part of tick period [ms]
+	uint32_t    m_FracPerTick;		///< fractional part of tick period [2^-32 ms]
+	uint32_t    m_FracAcc;			///< accumulated fractional milliseconds
+	uint16_t    m_NomMillis;		///< untrimmed tick period, integer part [ms]
+	uint32_t    m_NomFrac;			///< untrimmed tick period, fractional part [2^-32 ms]
+	int32_t     m_trim;				///< correction added to m_NomFrac
+	uint16_t    m_usPerCount;		///< counter period, integer part [us]
+	uint16_t    m_usPerCountFrac;	///< counter period, fractional part [2^-16 us]
+	uint16_t    m_period;			///< counts per interrupt (TOP+1)
+	uint8_t     m_prescale;			///< interrupts per tick
+	volatile uint8_t m_precount;	///< interrupts left until next tick
 	bool        m_handle_millis;
+#if AVRTIMERS_TIMEBASE >= 0
+	bool        m_keep_millis;		///< maintain m_millis etc, although not the timebase
+	/// @brief true if this timer maintains its own millis, also if there is no timebase timer
+	bool keeps_time() { 
+		return m_id == AVRTIMERS_TIMEBASE || m_keep_millis || m_handle_millis 
+			|| !s_timers[AVRTIMERS_TIMEBASE]; 
+	}
+	/// @brief the timer whose millis and micros this timer reports
+	AvrTimerBase* clock() { return keeps_time() ? this : s_timers[AVRTIMERS_TIMEBASE]; }
+#else
+	AvrTimerBase* clock() { return this; }
+#endif
+	bool        m_gated;			///< timer is switched off via PRR
+	uint8_t     m_tccrb;			///< TCCRnB saved while gated
+#if AVRTIMERS_PERSIST
+	uint8_t     m_slot;				///< persistent copy to write next
+	void restore_millis(void);
+#endif
+#if AVRTIMERS_MAX_CLKPS
+	/// configuration per system clock prescaler, precomputed in begin()
+	clkcfg_t    m_clkcfg[AVRTIMERS_MAX_CLKPS+1];
+	/// reprogram the timer for m_clkcfg[clkps], called with interrupts disabled
+	void (*m_reclock)(uint8_t clkps);
+	uint8_t     m_gated_clkps;		///< s_clkps when the timer was switched off via PRR
+	void apply_clkps(uint8_t clkps);
+#endif
+#if AVRTIMERS_IDLE_SCALING
+	uint16_t    m_rate_div;			///< interrupt rate is currently nominal rate / m_rate_div
+	uint8_t     m_cs0;				///< clock select at nominal rate
+	uint16_t    m_ocr0;				///< counts per interrupt at nominal rate
+	volatile uint16_t m_want_div;	///< rate divisor to switch to at the next tick
+	bool        m_hold_rate;		///< nominal rate needed, for PWM or a per-interrupt function
+	/// reprogram the timer for nominal rate / div, called with interrupts disabled.
+	/// `at_tick`: called right after a tick, keep the time since then, else keep the counter phase
+	bool (*m_retune)(uint16_t div, bool at_tick);
+
+	bool set_rate_div(uint16_t div, bool at_tick);
+	void rescale_idle(void);
+	void apply_rate_div(void);
+	void reset_rate_div(void);
+	void hold_rate(bool hold);
+#endif
+
+	static void calc_timebase(timebase_t& tb, uint32_t fclk, uint16_t div, uint16_t period, uint8_t pre=1);
+	void set_timebase(const timebase_t& tb);
+	void set_timebase(uint32_t fclk, uint16_t div, uint16_t period, uint8_t pre=1)
+		{ timebase_t tb; calc_timebase(tb,fclk,div,period,pre); set_timebase(tb); }
+	uint32_t counts_to_us(uint32_t counts);
+	uint16_t read_counter(bool& pending);
+#if AVRTIMERS_TRACE
+	friend class AvrTrace;
+	/// @brief record a trace event that started at counter value `start` and ends now
+	void trace(uint8_t what, uint16_t start) {
+		bool pending;
+		uint16_t end = read_counter(pending);
+		AvrTrace::record( (m_id << AvrTrace::TIMER_SHIFT) | (pending ? AvrTrace::OVERRUN : 0) | what,
+			(uint16_t)clock()->m_millis, start, end );
+	}
+#endif
+	/// @brief true if the ISR of this timer may enable interrupts, see AVRTIMERn_NESTING
+	bool nests() {
+		switch (m_id) {
+			case 0:  return AVRTIMER0_NESTING != AVRTIMERS_NEST_NONE;
+			case 1:  return AVRTIMER1_NESTING != AVRTIMERS_NEST_NONE;
+			default: return AVRTIMER2_NESTING != AVRTIMERS_NEST_NONE;
+		}
+	}
+#if AVRTIMERS_JITTER
+	static uint16_t s_rand;			///< state of the xorshift generator, never 0
+	/// @brief next pseudo-random number, xorshift with period 2^16-1
+	static uint16_t rand16(void) {
+		uint16_t x = s_rand;
+		x ^= x << 7;
+		x ^= x >> 9;
+		x ^= x << 8;
+		return s_rand = x;
+	}
+	/// @brief pseudo-random number 0..n-1
+	static uint16_t rand_below(uint16_t n) { return ((uint32_t)rand16() * n) >> 16; }
+	void draw_period(task_t* p);
+#endif
+	/// @brief start the next period of a task that has just run
+	void restart(task_t* p) {
+		p->count = 0;
+#if AVRTIMERS_JITTER
+		if (p->jitter) draw_period(p);
+#endif
+	}
+	bool has_tasks(void);
+	void power_off(void);
+	void power_on(void);
 };
 
 
@@ -127,11 +484,22 @@ protected:
 	/// prescaler per clock-select value (see datasheet)
 	static constexpr uint32_t T0_div[] = { 1,1,8,64,256,1024 };
 
-	static constexpr uint8_t calc_cs( uint32_t rate );
-	static constexpr uint8_t calc_ocr( uint32_t rate );
+	static constexpr uint8_t calc_cs( uint32_t fclk, uint32_t rate );
+	static constexpr uint8_t calc_ocr( uint32_t fclk, uint32_t rate );
 
+#if !AVRTIMER0_SHARED
+	// these reprogram TC0, which belongs to the Arduino core in shared mode
 	void setCR();
 	uint32_t init(uint8_t cs, uint8_t ocr, Polarity polB );
+	void load(uint8_t cs, uint8_t top, bool at_tick=false);
+ #if AVRTIMERS_MAX_CLKPS
+	void prepare_clocks(uint32_t rate);
+	static void reclock(uint8_t clkps);
+ #endif
+ #if AVRTIMERS_IDLE_SCALING
+	static bool retune(uint16_t div, bool at_tick);
+ #endif
+#endif // !AVRTIMER0_SHARED
 public:
 	/// pointer to singleton instance, used by ISR
 	static AvrTimer0* theInstance;
@@ -139,6 +507,9 @@ public:
 	AvrTimer0(void);
 	void start(void);
 	void stop(void);
+#if AVRTIMER0_SHARED
+	uint32_t begin_shared(uint8_t phase=0x80);
+#else
     void setPWM_B(uint8_t pwm, uint8_t top=UINT8_MAX);
 
 	/**
@@ -148,7 +519,14 @@ public:
 	 * @return actual interrupt rate [Hz]
 	 */
 	uint32_t begin(uint32_t rate, Polarity polB=Disabled )	
-		{ return init( calc_cs(rate), calc_ocr(rate), polB ); }
+	{ 
+		uint32_t arate = init( calc_cs(F_CPU,rate), calc_ocr(F_CPU,rate), polB );
+#if AVRTIMERS_MAX_CLKPS
+		prepare_clocks(rate);
+#endif
+		return arate;
+	}
+#endif // AVRTIMER0_SHARED
 };
 
 
@@ -168,11 +546,26 @@ protected:
 	/// prescaler per clock-select value (see datasheet)
 	static constexpr uint32_t T1_div[] = { 1,1,8,64,256,1024 };
 
-	static constexpr uint8_t calc_cs( uint32_t rate );
-	static constexpr uint16_t calc_ocr( uint32_t rate );
+	static constexpr uint8_t calc_cs( uint32_t fclk, uint32_t rate );
+	static constexpr uint16_t calc_ocr( uint32_t fclk, uint32_t rate );
 
 	void setCR();
 	uint32_t init(uint8_t cs, uint16_t ocr, Polarity polA, Polarity polB );
+	void load(uint8_t cs, uint16_t top, bool at_tick=false);
+#if AVRTIMERS_STOPWATCH
+	volatile uint32_t m_cycles;		///< CPU cycles at the last overflow
+	uint32_t    m_ovf_cycles;		///< CPU cycles per overflow
+	uint16_t    m_cycle_div;		///< CPU cycles per count
+	void set_cycles(uint8_t cs, uint16_t top) 
+		{ m_cycle_div = T1_div[cs]; m_ovf_cycles = (uint32_t)m_cycle_div * (top+1uL); }
+#endif
+#if AVRTIMERS_MAX_CLKPS
+	void prepare_clocks(uint32_t rate);
+	static void reclock(uint8_t clkps);
+#endif
+#if AVRTIMERS_IDLE_SCALING
+	static bool retune(uint16_t div, bool at_tick);
+#endif
 public:
 	static const uint16_t OCR_MAX = 10000;
 	/// pointer to singleton instance, used by ISR
@@ -181,6 +574,18 @@ public:
 	AvrTimer1(void);
 	void start(void);
 	void stop(void);
+#if AVRTIMERS_STOPWATCH
+	uint32_t cycles_now(void);
+	/// @brief count the cycles of one overflow, called by the ISR with interrupts disabled
+	void count_cycles(void) { m_cycles += m_ovf_cycles; }
+	/**
+	 * @brief Initialize Timer1 to count every CPU cycle, with the longest period, 
+	 * i.e. TOP=65534 and interrupts at F_CPU/65535. millis and tasks work as usual.
+	 * @return actual interrupt rate [Hz]
+	 */
+	uint32_t begin_cycles(Polarity polA=Disabled, Polarity polB=Disabled)
+		{ return init( 1, 65535u, polA, polB ); }
+#endif
     void setPWM_A(uint16_t pwm, uint16_t top=INT16_MAX);
     void setPWM_B(uint16_t pwm, uint16_t top=INT16_MAX);
 
@@ -193,7 +598,13 @@ public:
 	 * @return actual interrupt rate [Hz]
 	 */
 	uint32_t begin(uint32_t rate, Polarity polA=Disabled, Polarity polB=Disabled )
-		{ return init( calc_cs(rate), calc_ocr(rate), polA, polB ); }
+	{ 
+		uint32_t arate = init( calc_cs(F_CPU,rate), calc_ocr(F_CPU,rate), polA, polB );
+#if AVRTIMERS_MAX_CLKPS
+		prepare_clocks(rate);
+#endif
+		return arate;
+	}
 };
 
 
@@ -207,8 +618,8 @@ class AvrTimer2 : public AvrTimerBase
 protected:
 	bool        m_async;
 	uint8_t     m_ocr;
-	uint8_t     m_prescale;
 	isr_t 	    m_isr;
+	uint32_t    m_fclk;
 	
 	/// prescaler per clock-select value (see datasheet)
 	static constexpr uint32_t T2_div[] = { 1,1,8,32,64,128,256,1024 };
@@ -219,6 +630,14 @@ protected:
 
 	uint32_t set_rate(uint8_t cs, uint8_t ocr, uint8_t prescaler, uint32_t fclk=F_CPU, bool async=false);
 	uint32_t init(uint8_t cs, uint8_t ocr, uint8_t prescaler, isr_t isr=NULL, uint32_t fclk=F_CPU, bool async=false);
+	void load(uint8_t cs, uint8_t top, bool at_tick=false);
+#if AVRTIMERS_MAX_CLKPS
+	void prepare_clocks(uint32_t rate, uint32_t fclk);
+	static void reclock(uint8_t clkps);
+#endif
+#if AVRTIMERS_IDLE_SCALING
+	static bool retune(uint16_t div, bool at_tick);
+#endif
 public:
 	/// pointer to singleton instance, used by ISR
 	static AvrTimer2* theInstance;
@@ -240,9 +659,15 @@ public:
 	 * @return actual interrupt rate [Hz]
 	 */
 	uint32_t begin(uint32_t rate, uint32_t tickrate=0, isr_t isr=NULL, uint32_t fclk=F_CPU, bool async=false)
-		{ return init( calc_cs(fclk,rate), calc_ocr(fclk,rate), calc_pre(rate,tickrate?tickrate:rate), isr, fclk, async ); }
+	{ 
+		uint32_t arate = init( calc_cs(fclk,rate), calc_ocr(fclk,rate), calc_pre(rate,tickrate?tickrate:rate), isr, fclk, async ); 
+#if AVRTIMERS_MAX_CLKPS
+		if (!async) prepare_clocks(rate, fclk);
+#endif
+		return arate;
+	}
 	uint32_t set_rate(uint32_t rate, uint32_t fclk=F_CPU, bool async=false)
-		{ return set_rate( calc_cs(fclk,rate), calc_ocr(fclk,rate), fclk, async ); }
+		{ return set_rate( calc_cs(fclk,rate), calc_ocr(fclk,rate), m_prescale, fclk, async ); }
 };
 
 
@@ -252,14 +677,13 @@ public:
 /**
  * @brief Calculate clock select value CSn[2:0], at compile time if possible 
  * 
+ * @param fclk  timer clock [Hz]
  * @param rate  desired interrupt rate [Hz]
  * @return constexpr uint8_t  value for CS0[2:0] in TCCR0B
  */
 constexpr 
-uint8_t AvrTimer0::calc_cs( uint32_t rate )
+uint8_t AvrTimer0::calc_cs( uint32_t fclk, uint32_t rate )
 {
-	const uint32_t constexpr fclk = F_CPU;
-
 	if      (fclk / (rate * T0_div[1]) < 256uL) return 1;
 	else if (fclk / (rate * T0_div[2]) < 256uL) return 2;
 	else if (fclk / (rate * T0_div[3]) < 256uL) return 3;
@@ -274,25 +698,22 @@ uint8_t AvrTimer0::calc_cs( uint32_t rate )
 /**
  * @brief Calculate OCR value, at compile time if possible 
  * 
+ * @param fclk  timer clock [Hz]
  * @param rate  desired interrupt rate [Hz]
  * @return constexpr uint8_t  divider ( 1 + value to write to OCR0A )
  */
 constexpr 
-uint8_t AvrTimer0::calc_ocr( uint32_t rate )
+uint8_t AvrTimer0::calc_ocr( uint32_t fclk, uint32_t rate )
 {
-	const uint32_t constexpr fclk = F_CPU;
-	
-	const uint8_t cs = calc_cs( rate );
+	const uint8_t cs = calc_cs( fclk, rate );
 	return cs ? fclk / (rate * T0_div[cs]) : 0;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
 constexpr 
-uint8_t AvrTimer1::calc_cs( uint32_t rate )
+uint8_t AvrTimer1::calc_cs( uint32_t fclk, uint32_t rate )
 {
-	const uint32_t constexpr fclk = F_CPU;
-	
 	if (fclk / (rate * T1_div[1]) < 32767uL) return 1;
 	else if (fclk / (rate * T1_div[2]) < 32767uL) return 2;
 	else if (fclk / (rate * T1_div[3]) < 32767uL) return 3;
@@ -303,28 +724,32 @@ uint8_t AvrTimer1::calc_cs( uint32_t rate )
 
 
 constexpr 
-uint16_t AvrTimer1::calc_ocr( uint32_t rate )
+uint16_t AvrTimer1::calc_ocr( uint32_t fclk, uint32_t rate )
 {
-	const uint32_t constexpr fclk = F_CPU;
-	
-	const uint8_t cs = calc_cs( rate );
+	const uint8_t cs = calc_cs( fclk, rate );
 	return cs ? fclk / (rate * T1_div[cs]) : 0;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
+// OCR2A is rounded in calc_ocr(), so check the rounded value against the limit
+#define T2_OCR(k) ((fclk + rate * T2_div[k] / 2) / (rate * T2_div[k]))
+
 constexpr 
 uint8_t AvrTimer2::calc_cs( uint32_t fclk, uint32_t rate )
 {
-	if (fclk / (rate * T2_div[1]) < 256uL) return 1;
-	else if (fclk / (rate * T2_div[2]) < 256uL) return 2;
-	else if (fclk / (rate * T2_div[3]) < 256uL) return 3;
-	else if (fclk / (rate * T2_div[4]) < 256uL) return 4;
-	else if (fclk / (rate * T2_div[5]) < 256uL) return 5;
-	else if (fclk / (rate * T2_div[6]) < 256uL) return 6;
+	if (T2_OCR(1) < 256uL) return 1;
+	else if (T2_OCR(2) < 256uL) return 2;
+	else if (T2_OCR(3) < 256uL) return 3;
+	else if (T2_OCR(4) < 256uL) return 4;
+	else if (T2_OCR(5) < 256uL) return 5;
+	else if (T2_OCR(6) < 256uL) return 6;
+	else if (T2_OCR(7) < 256uL) return 7;
 	else return 0;
 }
 
+#undef T2_OCR
+
 
 constexpr 
 uint8_t AvrTimer2::calc_ocr( uint32_t fclk, uint32_t rate )
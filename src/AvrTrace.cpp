@@ -0,0 +1,153 @@
+/**
+ * @file 		  AvrTrace.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrTrace.cpp $
+ *
+ * @brief  Ring buffer of binary trace events from timer ISRs and tasks.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <util/atomic.h>
+#include <avr/io.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "AvrTimers.h"
+
+#if AVRTIMERS_TRACE
+
+static_assert( (AVRTIMERS_TRACE & (AVRTIMERS_TRACE-1)) == 0, "AVRTIMERS_TRACE must be a power of 2" );
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+#define TRACE_MASK (AVRTIMERS_TRACE-1)
+
+AvrTrace::trace_event_t AvrTrace::s_buf[AVRTIMERS_TRACE];
+volatile uint16_t AvrTrace::s_head = 0;
+uint16_t AvrTrace::s_tail = 0;
+uint16_t AvrTrace::s_lost = 0;
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Store one event, overwriting the oldest if the buffer is full. 
+ * Called from ISRs, possibly nested.
+ */
+void AvrTrace::record(uint8_t info, uint16_t tick, uint16_t start, uint16_t end)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		uint16_t h = s_head;
+		trace_event_t* e = &s_buf[h & TRACE_MASK];
+		e->info = info;
+		e->tick = tick;
+		e->start = start;
+		e->end = end;
+		s_head = h+1;
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief read s_head without disabling interrupts: retry until two reads agree
+uint16_t AvrTrace::get_head(void)
+{
+	uint16_t h;
+	do { h = s_head; } while (h != s_head);
+	return h;
+}
+
+/**
+ * @brief Get the oldest event not read yet. Call from the main loop only.
+ * @return false if there is no new event
+ */
+bool AvrTrace::read(trace_event_t& ev)
+{
+	for (;;) {
+		uint16_t h = get_head();
+		if (h == s_tail) return false;
+		if ((uint16_t)(h - s_tail) > AVRTIMERS_TRACE) {
+			// the oldest unread events have been overwritten
+			s_lost += (h - s_tail) - AVRTIMERS_TRACE;
+			s_tail = h - AVRTIMERS_TRACE;
+		}
+		ev = s_buf[s_tail & TRACE_MASK];
+		// the slot is overwritten when event s_tail+AVRTIMERS_TRACE is stored
+		if ((uint16_t)(get_head() - s_tail) <= AVRTIMERS_TRACE) {
+			s_tail++;
+			return true;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief send one byte via USART0, polled. The UART must be initialized.
+static void uart_put(uint8_t c)
+{
+#ifdef UDR0
+	while (!(UCSR0A & _BV(UDRE0))) {}
+	UDR0 = c;
+#endif
+}
+
+
+static void put16(AvrTrace::putbyte_t put, uint16_t x)
+{
+	put( x & 0xFF );
+	put( x >> 8 );
+}
+
+
+/**
+ * @brief Send all unread events in binary, see class description for the format.
+ * Events recorded while dumping are left for the next call, so that dump() 
+ * returns even if the ISRs record events faster than they can be sent.
+ * @param put  function to send one byte, default is USART0 polled
+ */
+void AvrTrace::dump(putbyte_t put)
+{
+	if (!put) put = uart_put;
+
+	put('A'); put('T'); put(1); put(sizeof(trace_event_t));
+	for (uint8_t i=0; i<3; i++) {
+		AvrTimerBase* t = AvrTimerBase::s_timers[i];
+		put( t != NULL );
+		put16( put, t ? t->m_usPerCount : 0 );
+		put16( put, t ? t->m_usPerCountFrac : 0 );
+		put16( put, t ? t->m_period : 0 );
+	}
+
+	uint16_t end = get_head();
+	trace_event_t ev;
+	while ((int16_t)(end - s_tail) > 0 && read(ev)) {
+		put( ev.info );
+		put16( put, ev.tick );
+		put16( put, ev.start );
+		put16( put, ev.end );
+	}
+
+	put( END );
+	put16( put, s_lost );
+	put16( put, 0 );
+	put16( put, 0 );
+	s_lost = 0;
+}
+
+/** @} */
+
+#endif // AVRTIMERS_TRACE
@@ -0,0 +1,89 @@
+/**
+ * @file 		  AvrTrace.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrTrace.h $
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRTRACE_H_
+#define AVRTRACE_H_
+
+#include <stdint.h>
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+/**
+ * @brief Ring buffer of binary trace events, recorded by the timers.
+ * 
+ * Enabled by defining `AVRTIMERS_TRACE` as the number of events to keep, 
+ * a power of 2, e.g. 32 (7 bytes RAM per event). The timers record one 
+ * event per tick (call_tasks()), one per task called, and for Timer2 one 
+ * per call of the ISR function, with the counter value TCNTn at start and 
+ * end. When the buffer is full, the oldest events are overwritten, so it 
+ * always holds the most recent history.
+ *
+ * Writers (ISRs) disable interrupts only while storing the 7 bytes of an 
+ * event. The reader (main loop) doesn't block writers: read() copies an 
+ * event and then checks if it was overwritten in the meantime.
+ *
+ * dump() sends the buffer contents in binary, for decoding on a PC:
+ *  - header: 'A' 'T' version=1, event size=7, 
+ *    then for timers 0..2: present (1 byte), us per count (uint16_t), 
+ *    us per count fraction [2^-16 us] (uint16_t), counts per interrupt (uint16_t)
+ *  - events as in trace_event_t, oldest first, all values little endian
+ *  - end marker: an event with info=0xFF, tick = number of lost events
+ */
+class AvrTrace {
+public:
+	/// one trace event, 7 bytes
+	typedef struct __attribute__((packed)) _trace_event_t {
+		uint8_t  info;		///< timer (bits 7..6), overrun (bit 5), what (bits 2..0)
+		uint16_t tick;		///< low 16 bits of the timer's millis counter
+		uint16_t start;		///< TCNTn at start
+		uint16_t end;		///< TCNTn at end
+	} trace_event_t;
+
+	/// trace_event_t.info: what was traced, task index 0..3, or one of these
+	static const uint8_t ISR  = 6;		///< Timer2 ISR function
+	static const uint8_t TICK = 7;		///< whole call_tasks()
+	static const uint8_t WHAT_MASK = 0x07;
+	/// trace_event_t.info: the timer interrupt was pending at the end, i.e. overrun
+	static const uint8_t OVERRUN = 0x20;
+	static const uint8_t TIMER_SHIFT = 6;
+	/// trace_event_t.info of the end marker in dump()
+	static const uint8_t END = 0xFF;
+
+	typedef void (*putbyte_t)(uint8_t);
+
+	static void record(uint8_t info, uint16_t tick, uint16_t start, uint16_t end);
+	static bool read(trace_event_t& ev);
+	static void dump(putbyte_t put=NULL);
+	/// @brief number of events lost because the reader was too slow
+	static uint16_t lost() { return s_lost; }
+
+protected:
+	static trace_event_t s_buf[];
+	static volatile uint16_t s_head;	///< # of events written
+	static uint16_t s_tail;				///< # of events read
+	static uint16_t s_lost;
+
+	static uint16_t get_head(void);
+};
+
+/** @} */
+
+#endif // AVRTRACE_H_
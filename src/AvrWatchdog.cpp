@@ -0,0 +1,155 @@
+/**
+ * @file 		  AvrWatchdog.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrWatchdog.cpp $
+ *
+ * @brief  Software watchdog for tasks and main loop sections.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <util/atomic.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "AvrTimers.h"
+#if DEBUG_AVRTIMERS
+ #include "debugstream.h"
+#endif
+
+#if AVRTIMERS_WATCHDOG
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+/// record of a failure, survives the reset
+typedef struct _failure_t {
+	uint32_t millis;
+	uint8_t  id;
+	uint32_t check;		///< millis ^ id ^ FAILURE_MAGIC
+} failure_rec_t;
+
+#define FAILURE_MAGIC 0xA53CC35AuL
+
+static failure_rec_t s_record __attribute__((section(".noinit")));
+
+uint8_t AvrWatchdog::s_mcusr __attribute__((section(".noinit")));
+uint8_t AvrWatchdog::s_count[AVRTIMERS_WATCHDOG];
+uint8_t AvrWatchdog::s_period[AVRTIMERS_WATCHDOG];
+uint8_t AvrWatchdog::s_n = 0;
+uint8_t AvrWatchdog::s_failed = AvrWatchdog::NO_ENTITY;
+uint32_t AvrWatchdog::s_failed_ms = 0;
+AvrTimerBase* AvrWatchdog::s_timer = NULL;
+AvrWatchdog::failure_t AvrWatchdog::s_on_failure = NULL;
+
+//---------------------------------------------------------------------------
+
+#ifdef __AVR__
+
+extern "C" void avrwatchdog_init3(void) __attribute__((naked, used, section(".init3")));
+
+/// save and clear MCUSR, and stop the watchdog that is still running after a watchdog reset
+void avrwatchdog_init3(void)
+{
+	AvrWatchdog::s_mcusr = MCUSR;
+	MCUSR = 0;
+	wdt_disable();
+}
+
+#endif // __AVR__
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Start supervising, and pick up the record of a failure before the last reset.
+ * @param timer 	  timer that runs the check task
+ * @param scale 	  check every `scale` ticks of that timer
+ * @param on_failure  called when an entity fails, before the reset
+ */
+void AvrWatchdog::begin(AvrTimerBase& timer, uint16_t scale, failure_t on_failure)
+{
+	if ((s_record.millis ^ s_record.id ^ FAILURE_MAGIC) == s_record.check) {
+		s_failed = s_record.id;
+		s_failed_ms = s_record.millis;
+		s_record.check = ~s_record.check;
+#if DEBUG_AVRTIMERS
+		DEBUG_PRINTF(" WD: entity %u failed at %lu ms\r\n", s_failed, s_failed_ms );
+#endif
+	}
+	s_timer = &timer;
+	s_on_failure = on_failure;
+	timer.add_task( scale, check );
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief Register an entity to supervise. Supervision starts right away.
+ * @param period  max. ticks of the check task between calls to kick(), 1..255
+ * @return entity number for kick(), or NO_ENTITY if there is no room
+ */
+uint8_t AvrWatchdog::add(uint8_t period)
+{
+	if (s_n >= AVRTIMERS_WATCHDOG || period == 0) return NO_ENTITY;
+	uint8_t id = s_n;
+	s_period[id] = period;
+	s_count[id] = period;
+	s_n = id + 1;
+	return id;
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief start or stop supervising entity `id`
+void AvrWatchdog::enable(uint8_t id, bool enable)
+{
+	if (id >= s_n) return;
+	s_count[id] = enable ? s_period[id] : 0;
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief Count down all entities. Called from the timer task.
+void AvrWatchdog::check(void* arg)
+{
+	uint8_t* p = s_count;
+	for (uint8_t i=0; i<s_n; i++, p++) {
+		uint8_t c = *p;
+		if (c && --c == 0) fail(i);
+		*p = c;
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/// @brief Record the failed entity, call the failure handler, and reset.
+void AvrWatchdog::fail(uint8_t id)
+{
+	uint32_t ms = s_timer ? s_timer->get_millis() : 0;
+	cli();
+	s_record.millis = ms;
+	s_record.id = id;
+	s_record.check = ms ^ id ^ FAILURE_MAGIC;
+	if (s_on_failure) s_on_failure(id);
+	wdt_enable(WDTO_15MS);
+	for (;;) {}
+}
+
+/** @} */
+
+#endif // AVRTIMERS_WATCHDOG
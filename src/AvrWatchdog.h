@@ -0,0 +1,87 @@
+/**
+ * @file 		  AvrWatchdog.h
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: AvrWatchdog.h $
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#ifndef AVRWATCHDOG_H_
+#define AVRWATCHDOG_H_
+
+#include <stdint.h>
+
+class AvrTimerBase;
+
+/** 
+ * @addtogroup AvrTimers
+ * @{ 
+ */
+
+/**
+ * @brief Software watchdog: supervise tasks and main loop sections.
+ * 
+ * Enabled by defining `AVRTIMERS_WATCHDOG` as the maximum number of 
+ * supervised entities (2 bytes RAM each). begin() adds a check task to a 
+ * timer. Each entity is registered with add(), with a period in ticks of 
+ * that check task, and must call kick() at least once per period. If an 
+ * entity misses its period, its number and the time are recorded in 
+ * `.noinit` memory, an optional failure handler is called, and the 
+ * hardware watchdog resets the MCU. After the reset, get_failure() tells
+ * which entity failed.
+ *
+ * The check task costs one decrement per entity and tick. 
+ *
+ * After a watchdog reset, the hardware watchdog stays enabled. So MCUSR 
+ * is saved and cleared, and the watchdog is disabled, in `.init3` before 
+ * main(); get_reset_flags() returns the saved MCUSR.
+ */
+class AvrWatchdog {
+public:
+	/// failure handler, called with the number of the entity that failed
+	typedef void (*failure_t)(uint8_t id);
+	/// returned by add() if there is no room, and by get_failure() if there was no failure
+	static const uint8_t NO_ENTITY = 0xFF;
+
+	static void begin(AvrTimerBase& timer, uint16_t scale=1, failure_t on_failure=NULL);
+	static uint8_t add(uint8_t period);
+	/// @brief entity `id` is alive, restart its period. Also enables supervision again.
+	static void kick(uint8_t id) { if (id < s_n) s_count[id] = s_period[id]; }
+	static void enable(uint8_t id, bool enable=true);
+	static void disable(uint8_t id) { enable(id,false); }
+	static void check(void* arg=NULL);
+
+	/// @brief entity that caused the last reset, or NO_ENTITY
+	static uint8_t get_failure(void) { return s_failed; }
+	/// @brief millis of the supervising timer when the entity failed
+	static uint32_t get_failure_ms(void) { return s_failed_ms; }
+	/// @brief MCUSR at startup
+	static uint8_t get_reset_flags(void) { return s_mcusr; }
+
+	/// MCUSR, saved in `.init3`
+	static uint8_t s_mcusr;
+protected:
+	static uint8_t s_count[];		///< ticks left until failure, 0 if not supervised
+	static uint8_t s_period[];		///< period [ticks]
+	static uint8_t s_n;				///< # of entities added
+	static uint8_t s_failed;
+	static uint32_t s_failed_ms;
+	static AvrTimerBase* s_timer;
+	static failure_t s_on_failure;
+
+	static void fail(uint8_t id);
+};
+
+/** @} */
+
+#endif // AVRWATCHDOG_H_
@@ -0,0 +1,321 @@
+/**
+ * @file 		  pcprof.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: pcprof.cpp $
+ *
+ * @brief  Symbolize AvrProfiler dumps: flat profile per function.
+ *
+ * usage: pcprof [-b] [-n lines] firmware.elf [file]
+ *
+ * Reads the binary output of AvrProfiler::dump() from a file or stdin. The
+ * input may contain several dumps, and other output (e.g. debug text)
+ * between them. Dumps with the same address range are added up.
+ *
+ * The symbol table of the ELF file (the same build as the firmware that
+ * took the samples) maps code addresses to functions. Samples in a bucket
+ * that spans several functions are shared between them in proportion to
+ * the bytes of each function in that bucket, so with large buckets small
+ * functions get an estimate rather than an exact count. Prints a flat
+ * profile like gprof, sorted by samples, and with -b also each non-empty
+ * bucket with the functions it covers.
+ */
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <elf.h>
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <string>
+
+// must match AvrProfiler.h
+static const uint8_t PROFILE_VERSION = 1;
+static const int HEADER_SIZE = 3 + 2 + 1 + 2 + 2 + 4;
+
+/// histogram from one or more dumps
+struct profile_t {
+	uint32_t base = 0;			///< first address [bytes]
+	uint8_t  log2size = 0;		///< log2 of bucket size [bytes]
+	uint16_t nbuckets = 0;
+	uint64_t other = 0;			///< samples outside the range
+	uint64_t total = 0;
+	std::vector<uint64_t> hist;
+	uint32_t dumps = 0;
+};
+
+/// code symbol from the ELF file
+struct symbol_t {
+	uint32_t addr;
+	uint32_t size;
+	std::string name;
+};
+
+//---------------------------------------------------------------------------
+
+static uint16_t get16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t get32(const uint8_t* p) { return get16(p) | ((uint32_t)get16(p+2) << 16); }
+
+
+static bool read_file(FILE* in, std::vector<uint8_t>& data)
+{
+	int c;
+	while ((c = fgetc(in)) != EOF) data.push_back((uint8_t)c);
+	return !ferror(in);
+}
+
+
+static std::string demangle(const char* name)
+{
+	if (strncmp(name, "_Z", 2) != 0) return name;	// C or assembler symbol
+	int status = -1;
+	char* s = abi::__cxa_demangle(name, NULL, NULL, &status);
+	std::string result = (status == 0 && s) ? s : name;
+	free(s);
+	return result;
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief read the code symbols from an ELF32 little endian file (as made by avr-gcc),
+ * sorted by address, with a size for symbols that don't have one.
+ * @return false if this is not such a file or it has no symbol table
+ */
+static bool load_symbols(const char* fname, std::vector<symbol_t>& syms)
+{
+	FILE* f = fopen(fname, "rb");
+	if (!f) { perror(fname); return false; }
+	std::vector<uint8_t> elf;
+	bool ok = read_file(f, elf);
+	fclose(f);
+	if (!ok) { perror(fname); return false; }
+
+	if (elf.size() < sizeof(Elf32_Ehdr) || memcmp(&elf[0], ELFMAG, SELFMAG) != 0
+		|| elf[EI_CLASS] != ELFCLASS32 || elf[EI_DATA] != ELFDATA2LSB) {
+		fprintf(stderr, "%s: not a 32-bit little endian ELF file\n", fname);
+		return false;
+	}
+	Elf32_Ehdr eh;
+	memcpy(&eh, &elf[0], sizeof(eh));
+	if (eh.e_shoff == 0 || eh.e_shentsize != sizeof(Elf32_Shdr)
+		|| eh.e_shoff + (size_t)eh.e_shnum * sizeof(Elf32_Shdr) > elf.size()) {
+		fprintf(stderr, "%s: no section headers\n", fname);
+		return false;
+	}
+	std::vector<Elf32_Shdr> sh(eh.e_shnum);
+	memcpy(&sh[0], &elf[eh.e_shoff], eh.e_shnum * sizeof(Elf32_Shdr));
+
+	for (const Elf32_Shdr& s : sh) {
+		if (s.sh_type != SHT_SYMTAB || s.sh_link >= sh.size()) continue;
+		const Elf32_Shdr& strtab = sh[s.sh_link];
+		if (s.sh_offset + s.sh_size > elf.size() || strtab.sh_offset + strtab.sh_size > elf.size())
+			break;
+		size_t n = s.sh_size / sizeof(Elf32_Sym);
+		for (size_t i=0; i<n; i++) {
+			Elf32_Sym sym;
+			memcpy(&sym, &elf[s.sh_offset + i*sizeof(Elf32_Sym)], sizeof(sym));
+			uint8_t type = ELF32_ST_TYPE(sym.st_info);
+			if (type != STT_FUNC && type != STT_NOTYPE) continue;
+			if (sym.st_shndx == SHN_UNDEF || sym.st_shndx >= sh.size()) continue;
+			if (!(sh[sym.st_shndx].sh_flags & SHF_EXECINSTR)) continue;
+			if (sym.st_name >= strtab.sh_size) continue;
+			const char* name = (const char*)&elf[strtab.sh_offset + sym.st_name];
+			if (!*name || name[0]=='.') continue;		// local labels
+			syms.push_back( symbol_t{ sym.st_value, sym.st_size, demangle(name) } );
+		}
+		break;
+	}
+	if (syms.empty()) {
+		fprintf(stderr, "%s: no code symbols\n", fname);
+		return false;
+	}
+
+	// sort by address, functions with a size first, and drop aliases
+	std::stable_sort( syms.begin(), syms.end(), [](const symbol_t& a, const symbol_t& b) {
+		return a.addr < b.addr || (a.addr == b.addr && a.size > b.size);
+	});
+	std::vector<symbol_t> unique;
+	for (const symbol_t& s : syms)
+		if (unique.empty() || unique.back().addr != s.addr) unique.push_back(s);
+	syms.swap(unique);
+
+	// assembler symbols have no size: assume they extend to the next symbol
+	for (size_t i=0; i<syms.size(); i++) {
+		if (syms[i].size) continue;
+		syms[i].size = (i+1 < syms.size()) ? syms[i+1].addr - syms[i].addr : 2;
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief decode one dump starting at `p` (at the magic), add it to the profile
+ * @return number of bytes used, or 0 if this is not a valid dump
+ */
+static size_t decode_dump(const uint8_t* p, size_t len, profile_t& prof)
+{
+	if (len < HEADER_SIZE || p[2] != PROFILE_VERSION) return 0;
+	uint16_t base = get16(p+3);
+	uint8_t log2size = p[5];
+	uint16_t n = get16(p+6);
+	if (n == 0 || log2size > 16 || len < HEADER_SIZE + 2u*n) return 0;
+
+	if (prof.dumps && (prof.base != base || prof.log2size != log2size || prof.nbuckets != n)) {
+		fprintf(stderr, "warning: address range changed, using later dumps only\n");
+		prof = profile_t();
+	}
+	if (!prof.dumps) {
+		prof.base = base;
+		prof.log2size = log2size;
+		prof.nbuckets = n;
+		prof.hist.assign(n, 0);
+	}
+	prof.other += get16(p+8);
+	prof.total += get32(p+10);
+	for (uint16_t i=0; i<n; i++)
+		prof.hist[i] += get16(p + HEADER_SIZE + 2*i);
+	prof.dumps++;
+	return HEADER_SIZE + 2u*n;
+}
+
+
+/// @brief find and decode all dumps in the input
+static void decode(const std::vector<uint8_t>& in, profile_t& prof)
+{
+	size_t pos = 0;
+	while (pos + 2 <= in.size()) {
+		if (in[pos]=='A' && in[pos+1]=='P') {
+			size_t used = decode_dump( &in[pos], in.size()-pos, prof );
+			if (used) { pos += used; continue; }
+		}
+		pos++;
+	}
+}
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief share the samples of each bucket between the symbols it overlaps
+ * @return samples per symbol name; code not covered by any symbol is "<unknown>"
+ */
+static std::map<std::string,double> attribute(const profile_t& prof, const std::vector<symbol_t>& syms, bool list)
+{
+	std::map<std::string,double> result;
+	uint32_t size = 1u << prof.log2size;
+
+	for (uint16_t i=0; i<prof.nbuckets; i++) {
+		if (!prof.hist[i]) continue;
+		uint32_t lo = prof.base + i*size, hi = lo + size;
+		if (list) printf("%06X-%06X %8llu ", lo, hi-1, (unsigned long long)prof.hist[i]);
+
+		// first symbol that ends after `lo`
+		auto it = std::upper_bound( syms.begin(), syms.end(), lo,
+			[](uint32_t a, const symbol_t& s) { return a < s.addr; } );
+		if (it != syms.begin()) --it;
+		uint32_t covered = 0;
+		for (; it != syms.end() && it->addr < hi; ++it) {
+			uint32_t a = std::max(lo, it->addr), b = std::min(hi, it->addr + it->size);
+			if (b <= a) continue;
+			covered += b - a;
+			result[it->name] += (double)prof.hist[i] * (b - a) / size;
+			if (list) printf(" %s", it->name.c_str());
+		}
+		if (covered < size) {
+			result["<unknown>"] += (double)prof.hist[i] * (size - covered) / size;
+			if (list && !covered) printf(" <unknown>");
+		}
+		if (list) printf("\n");
+	}
+	return result;
+}
+
+
+static void print_flat(const profile_t& prof, const std::map<std::string,double>& samples, int lines)
+{
+	std::vector<std::pair<double,std::string>> sorted;
+	for (const auto& kv : samples) sorted.push_back( std::make_pair(kv.second, kv.first) );
+	std::sort( sorted.begin(), sorted.end(), [](const std::pair<double,std::string>& a, const std::pair<double,std::string>& b) {
+		return a.first > b.first;
+	});
+
+	double total = (double)prof.total;
+	printf("\nflat profile, %llu samples\n", (unsigned long long)prof.total);
+	printf("  %%time  cumul%%     samples  function\n");
+	double cumul = 0;
+	int n = 0;
+	for (const auto& e : sorted) {
+		if (lines && n++ >= lines) break;
+		cumul += e.first;
+		printf("%7.2f %7.2f %11.1f  %s\n", 100*e.first/total, 100*cumul/total, e.first, e.second.c_str());
+	}
+	if (prof.other)
+		printf("%7.2f         %11llu  <outside range>\n", 100*prof.other/total, (unsigned long long)prof.other);
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+	bool list = false;
+	int lines = 0;
+	int opt;
+	while ((opt = getopt(argc, argv, "bn:h")) != -1) {
+		switch (opt) {
+			case 'b': list = true; break;
+			case 'n': lines = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-b] [-n lines] firmware.elf [file]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (optind >= argc) {
+		fprintf(stderr, "usage: %s [-b] [-n lines] firmware.elf [file]\n", argv[0]);
+		return 2;
+	}
+
+	std::vector<symbol_t> syms;
+	if (!load_symbols(argv[optind], syms)) return 2;
+
+	FILE* in = stdin;
+	if (optind+1 < argc) {
+		in = fopen(argv[optind+1], "rb");
+		if (!in) { perror(argv[optind+1]); return 2; }
+	}
+	std::vector<uint8_t> data;
+	read_file(in, data);
+	if (in != stdin) fclose(in);
+
+	profile_t prof;
+	decode(data, prof);
+	if (!prof.dumps || !prof.total) {
+		fprintf(stderr, "no profile samples found\n");
+		return 1;
+	}
+
+	printf("%u dump(s), %06X-%06X in %u buckets of %u bytes, %llu samples\n",
+		prof.dumps, prof.base, prof.base + ((uint32_t)prof.nbuckets << prof.log2size) - 1,
+		prof.nbuckets, 1u << prof.log2size, (unsigned long long)prof.total );
+	if (list) printf("\nbucket          samples  functions\n");
+
+	std::map<std::string,double> samples = attribute(prof, syms, list);
+	print_flat(prof, samples, lines);
+	return 0;
+}
@@ -0,0 +1,333 @@
+/**
+ * @file 		  tracedecode.cpp
+ * @author		  Bernd Waldmann
+ * Created		: 18-Oct-2026
+ * Tabsize		: 4
+ *
+ * This Revision: $Id: tracedecode.cpp $
+ *
+ * @brief  Decode AvrTrace dumps: latency histograms, ISR load, Chrome trace JSON.
+ *
+ * usage: tracedecode [-w window_ms] [-j trace.json] [file]
+ *
+ * Reads the binary output of AvrTrace::dump() from a file or stdin. The
+ * input may contain several dumps, and other output (e.g. debug text) 
+ * between them. Prints, per timer and task:
+ *  - latency: time from the timer interrupt to the start of the task [us]
+ *  - duration: time from start to end of the task [us]
+ * as statistics and log2 histograms, then the share of CPU time spent in
+ * call_tasks() of each timer, per time window. With -j, also writes all 
+ * events as a Chrome trace / Perfetto JSON file (open in ui.perfetto.dev
+ * or chrome://tracing).
+ *
+ * Absolute time is reconstructed from the millis low word of each event 
+ * (unwrapped per timer), plus the counter value converted to microseconds.
+ */ 
+
+/*
+   Copyright (C) 2026 Bernd Waldmann
+
+   This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0. 
+   If a copy of the MPL was not distributed with this file, You can obtain one at http://mozilla.org/MPL/2.0/
+
+   SPDX-License-Identifier: MPL-2.0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include <map>
+#include <vector>
+#include <string>
+
+// must match AvrTrace.h
+static const uint8_t TRACE_VERSION = 1;
+static const uint8_t EVENT_SIZE = 7;
+static const uint8_t WHAT_ISR = 6;
+static const uint8_t WHAT_TICK = 7;
+static const uint8_t WHAT_MASK = 0x07;
+static const uint8_t OVERRUN = 0x20;
+static const uint8_t TIMER_SHIFT = 6;
+static const uint8_t END = 0xFF;
+static const int HEADER_SIZE = 4 + 3*7;
+
+static const int NBUCKETS = 20;		///< log2 histogram buckets, up to 2^19 us
+
+/// timebase of one timer, from the dump header
+typedef struct {
+	bool     present;
+	double   us_per_count;
+	uint16_t period;
+	int64_t  last_tick;				///< unwrapped millis of the previous event, -1 if none
+} timer_info_t;
+
+/// one decoded event, in absolute time
+typedef struct {
+	uint8_t timer, what;
+	bool    overrun;
+	double  start_us, dur_us, latency_us;
+} event_t;
+
+/// statistics for one timer/task
+typedef struct _stats_t {
+	uint32_t n = 0, overruns = 0;
+	double lat_min = INFINITY, lat_max = 0, lat_sum = 0, lat_sq = 0;
+	double dur_min = INFINITY, dur_max = 0, dur_sum = 0;
+	uint32_t lat_hist[NBUCKETS] = {0};
+	uint32_t dur_hist[NBUCKETS] = {0};
+} stats_t;
+
+static uint32_t s_lost = 0;
+static uint32_t s_dumps = 0;
+
+//---------------------------------------------------------------------------
+
+static uint16_t get16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+
+
+/// @brief name of a timer/task, like "T0 task 2"
+static std::string event_name(uint8_t timer, uint8_t what)
+{
+	char s[32];
+	if (what == WHAT_TICK)		snprintf(s, sizeof(s), "T%u tick", timer);
+	else if (what == WHAT_ISR)	snprintf(s, sizeof(s), "T%u isr", timer);
+	else						snprintf(s, sizeof(s), "T%u task %u", timer, what);
+	return s;
+}
+
+
+/// @brief log2 histogram bucket for a time [us]
+static int bucket(double us)
+{
+	int b = 0;
+	while (b < NBUCKETS-1 && us >= (double)(1uL << b)) b++;
+	return b;
+}
+
+
+/**
+ * @brief decode one dump starting at `p` (after the magic), append events
+ * @return number of bytes used, or 0 if this is not a valid dump
+ */
+static size_t decode_dump(const uint8_t* p, size_t len, timer_info_t* timers, std::vector<event_t>& events)
+{
+	if (len < HEADER_SIZE || p[2] != TRACE_VERSION || p[3] != EVENT_SIZE) return 0;
+
+	const uint8_t* h = p + 4;
+	for (int i=0; i<3; i++, h += 7) {
+		timer_info_t& t = timers[i];
+		t.present = h[0];
+		t.us_per_count = get16(h+1) + get16(h+3) / 65536.0;
+		t.period = get16(h+5);
+	}
+
+	size_t pos = HEADER_SIZE;
+	while (pos + EVENT_SIZE <= len) {
+		const uint8_t* e = p + pos;
+		pos += EVENT_SIZE;
+		if (e[0] == END) {
+			s_lost += get16(e+1);
+			s_dumps++;
+			return pos;
+		}
+		uint8_t id = e[0] >> TIMER_SHIFT;
+		timer_info_t& t = timers[id];
+		if (!t.present || t.period == 0) continue;
+
+		// unwrap the millis low word
+		uint16_t tick = get16(e+1);
+		int64_t ms;
+		if (t.last_tick < 0) {
+			ms = tick;
+		} else {
+			ms = (t.last_tick & ~0xFFFFLL) | tick;
+			if (ms < t.last_tick - 0x8000) ms += 0x10000;
+		}
+		t.last_tick = ms;
+
+		// the interrupt flag is set when the counter is at TOP, i.e. period-1
+		uint16_t start = get16(e+3), end = get16(e+5);
+		uint32_t since_irq = (start + 1u) % t.period;
+		uint32_t counts = (end >= start) ? end - start : end + t.period - start;
+
+		event_t ev;
+		ev.timer = id;
+		ev.what = e[0] & WHAT_MASK;
+		ev.overrun = e[0] & OVERRUN;
+		ev.latency_us = since_irq * t.us_per_count;
+		ev.dur_us = counts * t.us_per_count;
+		ev.start_us = ms * 1000.0 + ev.latency_us;
+		events.push_back(ev);
+	}
+	return 0;	// no end marker: truncated dump
+}
+
+
+/// @brief find and decode all dumps in the input
+static void decode(const std::vector<uint8_t>& in, std::vector<event_t>& events)
+{
+	timer_info_t timers[3];
+	for (int i=0; i<3; i++) timers[i].last_tick = -1;
+
+	size_t pos = 0;
+	while (pos + 2 <= in.size()) {
+		if (in[pos]=='A' && in[pos+1]=='T') {
+			size_t used = decode_dump( &in[pos], in.size()-pos, timers, events );
+			if (used) { pos += used; continue; }
+		}
+		pos++;
+	}
+}
+
+//---------------------------------------------------------------------------
+
+static void print_hist(const char* title, const uint32_t* hist, uint32_t n)
+{
+	int lo = 0, hi = NBUCKETS-1;
+	while (lo < NBUCKETS && !hist[lo]) lo++;
+	while (hi > lo && !hist[hi]) hi--;
+	printf("    %s:\n", title);
+	for (int b=lo; b<=hi; b++) {
+		double from = b ? (double)(1uL << (b-1)) : 0;
+		int bar = n ? (int)(50.0 * hist[b] / n + 0.5) : 0;
+		printf("      %7.0f.. %7lu us %8lu  %.*s\n", from, 1uL << b, (unsigned long)hist[b], 
+			bar, "##################################################");
+	}
+}
+
+
+static void print_stats(const std::vector<event_t>& events)
+{
+	std::map<std::pair<int,int>, stats_t> stats;
+	for (const event_t& e : events) {
+		stats_t& s = stats[std::make_pair(e.timer, e.what)];
+		s.n++;
+		if (e.overrun) s.overruns++;
+		if (e.latency_us < s.lat_min) s.lat_min = e.latency_us;
+		if (e.latency_us > s.lat_max) s.lat_max = e.latency_us;
+		s.lat_sum += e.latency_us;
+		s.lat_sq += e.latency_us * e.latency_us;
+		if (e.dur_us < s.dur_min) s.dur_min = e.dur_us;
+		if (e.dur_us > s.dur_max) s.dur_max = e.dur_us;
+		s.dur_sum += e.dur_us;
+		s.lat_hist[bucket(e.latency_us)]++;
+		s.dur_hist[bucket(e.dur_us)]++;
+	}
+
+	printf("%lu events from %lu dumps, %lu lost\n\n", 
+		(unsigned long)events.size(), (unsigned long)s_dumps, (unsigned long)s_lost);
+	for (auto& kv : stats) {
+		const stats_t& s = kv.second;
+		double mean = s.lat_sum / s.n;
+		double jitter = sqrt( fmax(0, s.lat_sq / s.n - mean*mean) );
+		printf("%s: %lu events, %lu overruns\n", 
+			event_name(kv.first.first, kv.first.second).c_str(), (unsigned long)s.n, (unsigned long)s.overruns);
+		printf("    latency  min %8.1f  mean %8.1f  max %8.1f us, jitter (std.dev.) %.1f us\n", 
+			s.lat_min, mean, s.lat_max, jitter);
+		printf("    duration min %8.1f  mean %8.1f  max %8.1f us\n", 
+			s.dur_min, s.dur_sum / s.n, s.dur_max);
+		print_hist( "latency", s.lat_hist, s.n );
+		print_hist( "duration", s.dur_hist, s.n );
+		printf("\n");
+	}
+}
+
+
+/// @brief CPU time spent in call_tasks() of each timer, per window
+static void print_load(const std::vector<event_t>& events, double window_ms)
+{
+	double t0 = INFINITY, t1 = -INFINITY;
+	for (const event_t& e : events) {
+		if (e.what != WHAT_TICK) continue;
+		if (e.start_us < t0) t0 = e.start_us;
+		if (e.start_us > t1) t1 = e.start_us;
+	}
+	if (t0 > t1) return;
+
+	double w = window_ms * 1000.0;
+	size_t nwin = (size_t)((t1 - t0) / w) + 1;
+	std::vector<double> busy[3];
+	for (int i=0; i<3; i++) busy[i].assign(nwin, 0.0);
+	for (const event_t& e : events) {
+		if (e.what != WHAT_TICK) continue;
+		busy[e.timer][(size_t)((e.start_us - t0) / w)] += e.dur_us;
+	}
+
+	printf("ISR load per %.0f ms window [%% of CPU time in call_tasks()]:\n", window_ms);
+	printf("  %12s %7s %7s %7s\n", "time [ms]", "T0", "T1", "T2");
+	for (size_t k=0; k<nwin; k++) {
+		printf("  %12.0f", (t0 + k*w) / 1000.0);
+		for (int i=0; i<3; i++) printf(" %6.2f%%", 100.0 * busy[i][k] / w);
+		printf("\n");
+	}
+}
+
+
+/// @brief write events in Chrome trace event format
+static bool write_json(const char* fname, const std::vector<event_t>& events)
+{
+	FILE* f = fopen(fname, "w");
+	if (!f) return false;
+	fprintf(f, "{\"traceEvents\":[\n");
+	for (int i=0; i<3; i++) {
+		fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Timer%d\"}},\n", i, i);
+	}
+	for (size_t k=0; k<events.size(); k++) {
+		const event_t& e = events[k];
+		fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+			"\"args\":{\"latency_us\":%.1f,\"overrun\":%s}}%s\n",
+			event_name(e.timer, e.what).c_str(), e.timer, e.start_us, e.dur_us, 
+			e.latency_us, e.overrun ? "true" : "false", (k+1 < events.size()) ? "," : "" );
+	}
+	fprintf(f, "],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(f);
+	return true;
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+	double window_ms = 1000;
+	const char* json = NULL;
+	int opt;
+	while ((opt = getopt(argc, argv, "w:j:h")) != -1) {
+		switch (opt) {
+			case 'w': window_ms = atof(optarg); break;
+			case 'j': json = optarg; break;
+			default:
+				fprintf(stderr, "usage: %s [-w window_ms] [-j trace.json] [file]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (window_ms <= 0) window_ms = 1000;
+
+	FILE* in = stdin;
+	if (optind < argc) {
+		in = fopen(argv[optind], "rb");
+		if (!in) { perror(argv[optind]); return 2; }
+	}
+	std::vector<uint8_t> data;
+	int c;
+	while ((c = fgetc(in)) != EOF) data.push_back((uint8_t)c);
+	if (in != stdin) fclose(in);
+
+	std::vector<event_t> events;
+	decode(data, events);
+	if (events.empty()) {
+		fprintf(stderr, "no trace events found\n");
+		return 1;
+	}
+
+	print_stats(events);
+	print_load(events, window_ms);
+	if (json && !write_json(json, events)) {
+		perror(json);
+		return 1;
+	}
+	return 0;
+}